@@ -1,2 +1,12 @@
 TEMPLATE = subdirs
-SUBDIRS += src
+SUBDIRS += src \
+           cli \
+           lib \
+           tests \
+           benchmarks
+
+cli.subdir = src/cli
+lib.subdir = src/lib
+
+# the C interface test links the library
+tests.depends = lib
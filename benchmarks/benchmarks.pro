@@ -0,0 +1,4 @@
+# benchmarks, not run by make check
+
+TEMPLATE = subdirs
+SUBDIRS += directions
@@ -0,0 +1,218 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+//---------------------------------------------------------
+// benchmark the lookup of note directions (staff text and tempo)
+//
+// usage: bench_directions [scale [repeats [file.enc ...]]]
+//
+// the measures of each file are repeated scale times (default 1000),
+// the directions of all notes are looked up repeats times (default 20)
+// both through NoteConnector::direction() and by scanning the measure
+// of each note, as was done before the directions table was added
+// a file without directions gets a synthetic one on every second note
+// (alternating staff text and tempo), plus one per measure in a voice
+// without notes
+// fails if the two lookups return a different direction for any note
+//---------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+
+#include "encfile.h"
+#include "encreader.h"
+#include "noteconnector.h"
+
+
+//---------------------------------------------------------
+// scaleMeasures - repeat the measure blocks (from the first MEAS
+// up to TITL or the end of the file) scale times
+//---------------------------------------------------------
+
+static QByteArray scaleMeasures(const QByteArray& data, const int scale)
+{
+    const qsizetype first = data.indexOf("MEAS");
+    if (first < 0)
+        return data;
+    qsizetype end = data.indexOf("TITL", first);
+    if (end < 0)
+        end = data.size();
+    const QByteArray measures = data.mid(first, end - first);
+    QByteArray res = data.left(end);
+    for (int i = 1; i < scale; ++i)
+        res += measures;
+    res += data.mid(end);
+    return res;
+}
+
+
+//---------------------------------------------------------
+// scanDirection - find the direction of a note by scanning its measure
+//---------------------------------------------------------
+
+static const EncMeasureElemOrnament* scanDirection(const EncMeasure& m, const EncMeasureElemNote* const note)
+{
+    for (const auto elem : m.measureElems()) {
+        if (const EncMeasureElemOrnament* const orn = dynamic_cast<const EncMeasureElemOrnament* const>(elem)) {
+            if (note->m_tick == orn->m_tick
+                && note->m_voice == orn->m_voice
+                && note->m_staffIdx == orn->m_staffIdx
+                && (orn->type() == ornamentType::STAFFTEXT
+                    || orn->type() == ornamentType::TEMPO)) {
+                return orn;
+            }
+        }
+    }
+    return nullptr;
+}
+
+
+//---------------------------------------------------------
+// addDirections - add a direction to every second note and an unmatched
+// one to each measure, returns the number of directions added
+// the parsed measures are only available read-only, the file owns
+// the elements added
+//---------------------------------------------------------
+
+static int addDirections(const EncFile& ef)
+{
+    int res = 0;
+    int noteNr = 0;
+    for (const auto& m : ef.measures()) {
+        auto& measure = const_cast<EncMeasure&>(m);
+        std::vector<const EncMeasureElemNote*> notes;
+        for (const auto elem : m.measureElems()) {
+            if (const auto note = dynamic_cast<const EncMeasureElemNote*>(elem))
+                notes.push_back(note);
+        }
+        for (const auto note : notes) {
+            if (noteNr++ % 2 != 0)
+                continue;
+            const auto orn = new EncMeasureElemOrnament(note->m_tick, static_cast<quint8>(elemType::ORNAMENT), note->m_voice);
+            orn->m_staffIdx = note->m_staffIdx;
+            orn->setType(res % 2 == 0 ? ornamentType::STAFFTEXT : ornamentType::TEMPO);
+            measure.push_back(orn);
+            ++res;
+        }
+        // voice 15 is not used for notes
+        const auto orn = new EncMeasureElemOrnament(0, static_cast<quint8>(elemType::ORNAMENT), 15);
+        orn->setType(ornamentType::STAFFTEXT);
+        measure.push_back(orn);
+        ++res;
+    }
+    return res;
+}
+
+
+//---------------------------------------------------------
+// benchmark - benchmark a single file, returns false on error
+//---------------------------------------------------------
+
+static bool benchmark(const QString& filename, const int scale, const int repeats)
+{
+    QByteArray data;
+    QString error = loadEncFile(filename, data);
+    EncFile ef;
+    if (error.isEmpty())
+        error = readEncData(scaleMeasures(data, scale), ef);
+    if (!error.isEmpty()) {
+        std::printf("%s: %s\n", qPrintable(filename), qPrintable(error));
+        return false;
+    }
+
+    // the notes and their measures
+    std::vector<std::pair<const EncMeasure*, const EncMeasureElemNote*>> notes;
+    int directions = 0;
+    int synthetic = 0;
+    for (const auto& m : ef.measures()) {
+        for (const auto elem : m.measureElems()) {
+            if (const auto note = dynamic_cast<const EncMeasureElemNote*>(elem))
+                notes.emplace_back(&m, note);
+            else if (const auto orn = dynamic_cast<const EncMeasureElemOrnament*>(elem))
+                directions += orn->type() == ornamentType::STAFFTEXT || orn->type() == ornamentType::TEMPO;
+        }
+    }
+    if (directions == 0) {
+        synthetic = addDirections(ef);
+        directions = synthetic;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const NoteConnector nc(ef);
+    const qint64 build = timer.nsecsElapsed();
+
+    size_t found = 0;
+    timer.restart();
+    for (int r = 0; r < repeats; ++r) {
+        for (const auto& n : notes)
+            found += nc.direction(n.second) != nullptr;
+    }
+    const qint64 lookup = timer.nsecsElapsed();
+
+    size_t scanned = 0;
+    timer.restart();
+    for (int r = 0; r < repeats; ++r) {
+        for (const auto& n : notes)
+            scanned += scanDirection(*n.first, n.second) != nullptr;
+    }
+    const qint64 scan = timer.nsecsElapsed();
+
+    // the same direction for every note
+    size_t mismatches = 0;
+    for (const auto& n : notes)
+        mismatches += nc.direction(n.second) != scanDirection(*n.first, n.second);
+
+    const double lookups = static_cast<double>(notes.size()) * repeats;
+    std::printf("%s: %zu measures, %zu notes, %d directions%s\n",
+                qPrintable(filename), ef.measures().size(), notes.size(), directions, synthetic > 0 ? " (synthetic)" : "");
+    std::printf("  NoteConnector    %10.3f ms\n", build / 1e6);
+    std::printf("  table lookup     %10.1f ns/note\n", lookups > 0 ? lookup / lookups : 0.0);
+    std::printf("  measure scan     %10.1f ns/note\n", lookups > 0 ? scan / lookups : 0.0);
+    if (found != scanned || mismatches > 0) {
+        std::printf("  ERROR: table found %zu directions, scan found %zu, %zu notes differ\n", found, scanned, mismatches);
+        return false;
+    }
+    return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const int scale = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int repeats = argc > 2 ? std::atoi(argv[2]) : 20;
+    QStringList files;
+    for (int i = 3; i < argc; ++i)
+        files.append(QString::fromLocal8Bit(argv[i]));
+    if (files.isEmpty()) {
+        files.append(QString(TESTDATA_DIR) + "/dinamikoj.enc");
+        files.append(QString(TESTDATA_DIR) + "/simboloj.enc");
+    }
+
+    bool ok = true;
+    for (const auto& f : files)
+        ok = benchmark(f, scale < 1 ? 1 : scale, repeats < 1 ? 1 : repeats) && ok;
+    return ok ? 0 : 1;
+}
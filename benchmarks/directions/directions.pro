@@ -0,0 +1,15 @@
+QT       = core
+
+CONFIG  += c++11
+
+TARGET   = bench_directions
+TEMPLATE = app
+CONFIG  += console
+CONFIG  -= app_bundle
+
+DEFINES += QT_NO_DEBUG_OUTPUT
+DEFINES += TESTDATA_DIR=\\\"$$PWD/../../testdata\\\"
+
+include(../../src/core.pri)
+
+SOURCES += directions.cpp
@@ -17,52 +17,16 @@
 /*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
 /*****************************************************************************/
 
-#include <iostream>
 #include <iomanip>
 #include <map>
+#include <string>
 
 #include <QtDebug>
 
 #include "encfile.h"
 #include "analysisfile.h"
-
-//---------------------------------------------------------
-// midipitch2xml
-//---------------------------------------------------------
-
-static int alterTab[12] = { 0,   1,   0,   1,   0,  0,   1,   0,   1,   0,   1,   0 };
-static char noteTab[12] = { 'C', 'C', 'D', 'D', 'E', 'F', 'F', 'G', 'G', 'A', 'A', 'B' };
-
-// determine pitch spelling based on pitch
-
-static void midipitch2xml(const quint8 pitch, char& step, int& alter, int& octave)
-{
-    // 60 = C 4
-    step   = noteTab[pitch % 12];
-    alter  = alterTab[pitch % 12];
-    octave = pitch / 12 - 1;
-}
-
-
-//---------------------------------------------------------
-// faceValue2string
-//---------------------------------------------------------
-
-static const char* faceValue2string(const quint8 faceValue)
-{
-    switch (faceValue) {
-    case 1: return "/1";
-    case 2: return "/2";
-    case 3: return "/4";
-    case 4: return "/8";
-    case 5: return "/16";
-    case 6: return "/32";
-    case 7: return "/64";
-    case 8: return "/128";
-    }
-
-    return "???";
-}
+#include "encreader.h"
+#include "notevalues.h"
 
 static const char* stafftype2string (const quint8 type)
 {
@@ -213,8 +177,8 @@ static const char* tuplet2string(quint8 tuplet)
 // AnalysisFile - write analysis result
 //---------------------------------------------------------
 
-AnalysisFile::AnalysisFile(const EncFile& ef)
-    : m_ef(ef)
+AnalysisFile::AnalysisFile(const EncFile& ef, QIODevice* device)
+    : m_device(device), m_ef(ef)
 {
 
 }
@@ -224,23 +188,26 @@ void AnalysisFile::write()
 {
     qDebug() << "AnalysisFile::write()";
     const EncHeader& hdr = m_ef.header();
-    qDebug() << "magic" << hdr.m_magic;
+    qDebug() << "magic" << toQString(hdr.m_magic);
     writeHeader();
     writeTitle();
     writeText();
     writeInstruments();
     writeLines();
     writeMeasures();
+    const std::string res = m_out.str();
+    if (m_device)
+        m_device->write(res.data(), static_cast<qint64>(res.size()));
 }
 
 
 void AnalysisFile::writeHeader()
 {
     const EncHeader& hdr = m_ef.header();
-    std::cout
+    m_out
         << "---- HEADER ----" << "\n"
         << std::hex
-        << "File magic:\t" << qPrintable(hdr.m_magic) << "\n"
+        << "File magic:\t" << qPrintable(toQString(hdr.m_magic)) << "\n"
         << "File format:\t" << std::setw(4) << static_cast<unsigned int>(hdr.m_chuMagio) << "\n"
         << "File version:\t" << std::setw(4) << hdr.m_chuVersio << "\n"
         << "Unknown1:\t" << std::setw(4) << hdr.m_nekon1 << "\n"
@@ -258,23 +225,23 @@ void AnalysisFile::writeHeader()
 void AnalysisFile::writeTitle()
 {
     const EncTitle& ttl = m_ef.title();
-    std::cout
+    m_out
         << "---- TITLES ----" << "\n"
         << "Size:\t\t" << ttl.m_varsize << " bytes" << "\n"
-        << "Title:\t\t" << qPrintable(ttl.m_title) << "\n";
+        << "Title:\t\t" << qPrintable(toQString(ttl.m_title)) << "\n";
     for (int i = 0; i < 2 && ttl.m_subtitle.size(); ++i)
-        std::cout << "Subtitle " << i + 1 << ":\t" << qPrintable(ttl.m_subtitle.at(i)) << "\n";
+        m_out << "Subtitle " << i + 1 << ":\t" << qPrintable(toQString(ttl.m_subtitle.at(i))) << "\n";
     for (int i = 0; i < 3 && ttl.m_instruction.size(); ++i)
-        std::cout << "Instruction " << i + 1 << ":\t" << qPrintable(ttl.m_instruction.at(i)) << "\n";
+        m_out << "Instruction " << i + 1 << ":\t" << qPrintable(toQString(ttl.m_instruction.at(i))) << "\n";
     for (int i = 0; i < 4 && ttl.m_author.size(); ++i)
-        std::cout << "Author " << i + 1 << ":\t" << qPrintable(ttl.m_author.at(i)) << "\n";
+        m_out << "Author " << i + 1 << ":\t" << qPrintable(toQString(ttl.m_author.at(i))) << "\n";
     for (int i = 0; i < 2 && ttl.m_header.size(); ++i)
-        std::cout << "Header " << i + 1 << ":\t" << qPrintable(ttl.m_header.at(i)) << "\n";
+        m_out << "Header " << i + 1 << ":\t" << qPrintable(toQString(ttl.m_header.at(i))) << "\n";
     for (int i = 0; i < 2 && ttl.m_footer.size(); ++i)
-        std::cout << "Footer " << i + 1 << ":\t" << qPrintable(ttl.m_footer.at(i)) << "\n";
+        m_out << "Footer " << i + 1 << ":\t" << qPrintable(toQString(ttl.m_footer.at(i))) << "\n";
     for (int i = 0; i < 6 && ttl.m_copyright.size(); ++i)
-        std::cout << "Copyright " << i + 1 << ":\t" << qPrintable(ttl.m_copyright.at(i)) << "\n";
-    std::cout
+        m_out << "Copyright " << i + 1 << ":\t" << qPrintable(toQString(ttl.m_copyright.at(i))) << "\n";
+    m_out
         << "\n";
 }
 
@@ -282,45 +249,45 @@ void AnalysisFile::writeTitle()
 void AnalysisFile::writeText()
 {
     const EncText& txt = m_ef.text();
-    std::cout
+    m_out
         << "---- TEXTS ----" << "\n"
         << "N texts:\t" << txt.m_texts.size() << "\n";
     for (unsigned int i = 0; i < txt.m_texts.size(); ++i)
-        std::cout << "Text " << i + 1 << ":\t\t" << qPrintable(txt.m_texts.at(i)) << "\n";
-    std::cout
+        m_out << "Text " << i + 1 << ":\t\t" << qPrintable(toQString(txt.m_texts.at(i))) << "\n";
+    m_out
         << "\n";
 }
 
 
 void AnalysisFile::writeInstruments()
 {
-    std::cout
+    m_out
         << "---- INSTRUMENTS ----" << "\n";
     int count = 0;
     for (const auto& s : m_ef.staves()) {
         ++count;
-        std::cout
-            << std::setw(2) << std::setfill('0') << count << ":\t\t" << qPrintable(s.m_name) << "\n";
+        m_out
+            << std::setw(2) << std::setfill('0') << count << ":\t\t" << qPrintable(toQString(s.m_name)) << "\n";
     }
-    std::cout
+    m_out
         << "\n";
 }
 
 
 void AnalysisFile::writeLines()
 {
-    std::cout
+    m_out
         << "---- SYSTEMS ----" << "\n";
     int count = 0;
     for (const auto& l : m_ef.lines()) {
         ++count;
-        std::cout
+        m_out
             << "--- System " << std::setw(2) << std::setfill('0') << count << "\n"
             << "type:\t\t0x" << std::hex << std::setw(2) << (l.m_offset & 0xFF) << "\n"
             << "measures:\t" << std::dec << static_cast<int>(l.m_measureCount) << "\n"
             ;
         writeLineStaffData(l);
-        std::cout
+        m_out
             << "\n";
     }
 }
@@ -329,10 +296,10 @@ void AnalysisFile::writeLines()
 void AnalysisFile::writeLineStaffData(const EncLine& line)
 {
     int count = 0;
-    std::cout
+    m_out
         << "Staff\ttype\tclef\tkey" << "\n";
     for (const auto& d : line.lineStaffData()) {
-        std::cout
+        m_out
             << count + 1
             << "\t" << stafftype2string(/* TODO */ static_cast<quint8>(d.m_staffType))
             << "\t" << cleftype2string(/* TODO */ static_cast<qint8>(d.m_clef))
@@ -345,12 +312,12 @@ void AnalysisFile::writeLineStaffData(const EncLine& line)
 
 void AnalysisFile::writeMeasures()
 {
-    std::cout
+    m_out
         << "---- MEASURES ----" << "\n";
     int count = 0;
     for (const auto& m : m_ef.measures()) {
         ++count;
-        std::cout
+        m_out
             << "--- Measure "   << count << "\n"
             << "size:\t\t" << m.m_varsize << " bytes" << "\n"
             << "tempo:\t\t" << m.m_bpm << " BPM" << "\n"
@@ -380,7 +347,7 @@ void AnalysisFile::writeMeasures()
                 writeMeasureElem(e.second);
             }
             */
-            std::cout << "--------------\n";
+            m_out << "--------------\n";
         }
 #endif
 #if 1
@@ -388,14 +355,14 @@ void AnalysisFile::writeMeasures()
             writeMeasureElem(e);
         }
 #endif
-        std::cout << "\n";
+        m_out << "\n";
     }
 }
 
 
 void AnalysisFile::writeMeasureElem(const EncMeasureElem* const elem)
 {
-    std::cout
+    m_out
         << static_cast<int>(elem->m_xoffset)
         << "\t" << elem->m_tick
         << "\t" << static_cast<int>(elem->m_voice)
@@ -418,7 +385,7 @@ void AnalysisFile::writeMeasureElem(const EncMeasureElem* const elem)
             adorno = note->articulationUp();
         else if (note->m_dotControl & 0x40)
             adorno = note->articulationDown();
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             //<< (isPercClef ? enc_lily_vpoz_frape (note->m_position)
@@ -432,14 +399,14 @@ void AnalysisFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemClef* const clef = dynamic_cast<const EncMeasureElemClef* const>(elem)) {
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             << clef2string(clef)
             << "\n";
     }
     else if (const EncMeasureElemOrnament* const orna = dynamic_cast<const EncMeasureElemOrnament* const>(elem)) {
-        std::cout
+        m_out
             << "\t" << static_cast<int>(orna->m_al_mezuro)
             << "\t" << static_cast<int>(orna->m_xoffset2)
             << "\t"
@@ -447,28 +414,28 @@ void AnalysisFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemLyric* const lyric = dynamic_cast<const EncMeasureElemLyric* const>(elem)) {
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             << lyric2string(lyric)
             << "\n";
     }
     else if (const EncMeasureElemTie* const tie = dynamic_cast<const EncMeasureElemTie* const>(elem)) {
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             << tie2string(tie)
             << "\n";
     }
     else if (const EncMeasureElemBeam* const beam = dynamic_cast<const EncMeasureElemBeam* const>(elem)) {
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             << beam2string(beam)
             << "\n";
     }
     else if (const EncMeasureElemRest* const rest = dynamic_cast<const EncMeasureElemRest* const>(elem)) {
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             << "R"
@@ -476,21 +443,21 @@ void AnalysisFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemChord* const chord = dynamic_cast<const EncMeasureElemChord* const>(elem)) {
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             << chord2string(chord)
             << "\n";
     }
     else if (const EncMeasureElemKeyChange* const key = dynamic_cast<const EncMeasureElemKeyChange* const>(elem)) {
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             << key2string(key)
             << "\n";
     }
     else if (const EncMeasureElemUnknown* const unknown = dynamic_cast<const EncMeasureElemUnknown* const>(elem)) {
-        std::cout
+        m_out
             << "\t"
             << "-\t-\t"
             << "Unknown (TODO) " << unknown
@@ -20,6 +20,10 @@
 #ifndef ANALYSISFILE_H
 #define ANALYSISFILE_H
 
+#include <sstream>
+
+#include <QIODevice>
+
 #include "encfile.h"
 
 
@@ -30,7 +34,7 @@
 class AnalysisFile
 {
 public:
-    AnalysisFile(const EncFile& ef);
+    AnalysisFile(const EncFile& ef, QIODevice* device);
     void write();
 private:
     void writeHeader();
@@ -41,7 +45,9 @@ private:
     void writeLineStaffData(const EncLine& line);
     void writeMeasures();
     void writeMeasureElem(const EncMeasureElem* const elem);
+    QIODevice* m_device;
     const EncFile& m_ef;
+    std::ostringstream m_out;   // the analysis is written to the device when complete
 };
 
 #endif // ANALYSISFILE_H
@@ -0,0 +1,20 @@
+# command line handling, shared by the console and GUI applications
+# depends on QtCore only
+
+include($$PWD/core.pri)
+
+SOURCES += $$PWD/analysisfile.cpp \
+           $$PWD/batchrunner.cpp \
+           $$PWD/commandline.cpp \
+           $$PWD/folderwatcher.cpp \
+           $$PWD/journal.cpp \
+           $$PWD/pipeline.cpp \
+           $$PWD/textfile.cpp
+
+HEADERS += $$PWD/analysisfile.h \
+           $$PWD/batchrunner.h \
+           $$PWD/commandline.h \
+           $$PWD/folderwatcher.h \
+           $$PWD/journal.h \
+           $$PWD/pipeline.h \
+           $$PWD/textfile.h
@@ -0,0 +1,280 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtDebug>
+
+#include "batchconverter.h"
+#include "encfile.h"
+#include "encreader.h"
+
+
+//---------------------------------------------------------
+// status2string - the text shown for a file status
+//---------------------------------------------------------
+
+static QString status2string(const BatchStatus status)
+{
+    switch (status) {
+    case BatchStatus::QUEUED:    return "queued";
+    case BatchStatus::RUNNING:   return "running";
+    case BatchStatus::DONE:      return "done";
+    case BatchStatus::FAILED:    return "failed";
+    case BatchStatus::CANCELLED: return "cancelled";
+    }
+    return "";
+}
+
+
+//---------------------------------------------------------
+// BatchConverter - constructor
+// the pool is bounded by the number of cores
+//---------------------------------------------------------
+
+BatchConverter::BatchConverter(QObject* parent)
+    : QAbstractListModel(parent)
+{
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+
+//---------------------------------------------------------
+// ~BatchConverter - destructor
+// files not yet started are dropped, running ones stop at the next measure
+//---------------------------------------------------------
+
+BatchConverter::~BatchConverter()
+{
+    m_cancel.cancel();
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+
+//---------------------------------------------------------
+// rowCount - the number of files in the source folder
+//---------------------------------------------------------
+
+int BatchConverter::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_files.size());
+}
+
+
+//---------------------------------------------------------
+// data - the name, status or error of a file
+//---------------------------------------------------------
+
+QVariant BatchConverter::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= rowCount())
+        return QVariant();
+
+    const auto& file = m_files.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:   return file.m_name;
+    case StatusRole: return status2string(file.m_status);
+    case ErrorRole:  return file.m_error;
+    }
+    return QVariant();
+}
+
+
+//---------------------------------------------------------
+// roleNames - the names used in QML delegates
+//---------------------------------------------------------
+
+QHash<int, QByteArray> BatchConverter::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[NameRole] = "name";
+    roles[StatusRole] = "status";
+    roles[ErrorRole] = "error";
+    return roles;
+}
+
+
+//---------------------------------------------------------
+// setSourceFolder - list the Encore files in folder
+//---------------------------------------------------------
+
+void BatchConverter::setSourceFolder(const QUrl& folder)
+{
+    if (isBusy())
+        return;
+
+    m_sourceFolder = folder.toLocalFile();
+    const QDir dir(m_sourceFolder);
+    beginResetModel();
+    m_files.clear();
+    for (const auto& name : dir.entryList(QStringList { "*.enc", "*.ENC" }, QDir::Files, QDir::Name)) {
+        BatchFile file;
+        file.m_name = name;
+        file.m_size = QFileInfo(dir.filePath(name)).size();
+        m_files.push_back(file);
+    }
+    endResetModel();
+    qDebug() << "BatchConverter: found" << m_files.size() << "files in" << m_sourceFolder;
+    m_summary = QString("%1 files").arg(m_files.size());
+    emit summaryChanged();
+}
+
+
+//---------------------------------------------------------
+// convert - queue all files for conversion into destinationFolder
+// returns immediately, the model is updated as files complete
+//---------------------------------------------------------
+
+void BatchConverter::convert(const QUrl& destinationFolder)
+{
+    if (isBusy() || m_files.empty())
+        return;
+
+    const QDir srcDir(m_sourceFolder);
+    const QDir dstDir(destinationFolder.toLocalFile());
+    m_cancel.reset();
+    m_running = static_cast<int>(m_files.size());
+    beginResetModel();
+    for (auto& file : m_files) {
+        file.m_status = BatchStatus::QUEUED;
+        file.m_error.clear();
+    }
+    endResetModel();
+    m_timer.start();
+    for (int row = 0; row < static_cast<int>(m_files.size()); ++row) {
+        const QString& name = m_files.at(row).m_name;
+        const QString inFile = srcDir.filePath(name);
+        const QString outFile = dstDir.filePath(QFileInfo(name).completeBaseName() + ".musicxml");
+        m_pool.start([this, row, inFile, outFile]() { convertFile(row, inFile, outFile); });
+    }
+    emit busyChanged();
+    updateSummary();
+}
+
+
+//---------------------------------------------------------
+// cancel - stop the batch
+// files not yet started are cancelled, running ones stop at the next measure
+//---------------------------------------------------------
+
+void BatchConverter::cancel()
+{
+    m_cancel.cancel();
+}
+
+
+//---------------------------------------------------------
+// convertFile - convert a single file, called in a pool thread
+// the status changes are forwarded to the GUI thread
+//---------------------------------------------------------
+
+void BatchConverter::convertFile(const int row, const QString& inFile, const QString& outFile)
+{
+    if (m_cancel.isCancelled()) {
+        QMetaObject::invokeMethod(this, [this, row]() { fileFinished(row, BatchStatus::CANCELLED, ""); }, Qt::QueuedConnection);
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this, row]() { fileStarted(row); }, Qt::QueuedConnection);
+
+    BatchStatus status = BatchStatus::DONE;
+    EncFile ef;
+    QString error = readEncFile(inFile, ef);
+    if (!error.isEmpty()) {
+        status = BatchStatus::FAILED;
+    }
+    else {
+        QFile file(outFile);
+        if (!file.open(QFile::WriteOnly)) {
+            status = BatchStatus::FAILED;
+            error = "cannot open MusicXML file";
+        }
+        else {
+            MxmlConverter mf(ef, &file);
+            mf.setCancellationToken(&m_cancel);
+            if (!mf.convertEncToMxml()) {
+                file.remove();
+                status = BatchStatus::CANCELLED;
+            }
+        }
+    }
+    QMetaObject::invokeMethod(this, [this, row, status, error]() { fileFinished(row, status, error); }, Qt::QueuedConnection);
+}
+
+
+//---------------------------------------------------------
+// fileStarted - a pool thread started converting the file in row
+//---------------------------------------------------------
+
+void BatchConverter::fileStarted(const int row)
+{
+    m_files.at(row).m_status = BatchStatus::RUNNING;
+    emit dataChanged(index(row), index(row), { StatusRole });
+}
+
+
+//---------------------------------------------------------
+// fileFinished - the file in row is done, failed or cancelled
+//---------------------------------------------------------
+
+void BatchConverter::fileFinished(const int row, const BatchStatus status, const QString& error)
+{
+    auto& file = m_files.at(row);
+    file.m_status = status;
+    file.m_error = error;
+    if (!error.isEmpty())
+        qWarning() << "BatchConverter:" << file.m_name << error;
+    emit dataChanged(index(row), index(row), { StatusRole, ErrorRole });
+    --m_running;
+    if (m_running == 0)
+        emit busyChanged();
+    updateSummary();
+}
+
+
+//---------------------------------------------------------
+// updateSummary - overall progress and throughput
+//---------------------------------------------------------
+
+void BatchConverter::updateSummary()
+{
+    int done = 0;
+    int failed = 0;
+    int cancelled = 0;
+    qint64 bytes = 0;
+    for (const auto& file : m_files) {
+        if (file.m_status == BatchStatus::DONE) {
+            ++done;
+            bytes += file.m_size;
+        }
+        else if (file.m_status == BatchStatus::FAILED)
+            ++failed;
+        else if (file.m_status == BatchStatus::CANCELLED)
+            ++cancelled;
+    }
+    const double seconds = m_timer.elapsed() / 1000.0;
+    const double filesPerSecond = seconds > 0 ? done / seconds : 0;
+    const double kbPerSecond = seconds > 0 ? bytes / 1024.0 / seconds : 0;
+    m_summary = QString("%1 of %2 files done, %3 failed, %4 cancelled, %5 files/s (%6 KiB/s)")
+                .arg(done).arg(m_files.size()).arg(failed).arg(cancelled)
+                .arg(filesPerSecond, 0, 'f', 1).arg(kbPerSecond, 0, 'f', 0);
+    emit summaryChanged();
+}
@@ -0,0 +1,92 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef BATCHCONVERTER_H
+#define BATCHCONVERTER_H
+
+#include <vector>
+
+#include <QAbstractListModel>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QUrl>
+
+#include "mxmlconverter.h"
+
+
+//---------------------------------------------------------
+// the state of a single file in a batch conversion
+//---------------------------------------------------------
+
+enum class BatchStatus
+{
+    QUEUED, RUNNING, DONE, FAILED, CANCELLED
+};
+
+struct BatchFile
+{
+    QString m_name;                     // file name relative to the source folder
+    BatchStatus m_status { BatchStatus::QUEUED };
+    QString m_error;                    // readEncFile() error text if failed
+    qint64 m_size { 0 };                // input size in bytes
+};
+
+
+//---------------------------------------------------------
+// the batch converter converts all Encore files in a source folder
+// into MusicXML files in a destination folder
+// the files are converted concurrently on a bounded worker pool,
+// the model exposes each file with its status to QML
+//---------------------------------------------------------
+
+class BatchConverter : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(bool busy READ isBusy NOTIFY busyChanged)
+    Q_PROPERTY(QString summary READ getSummary NOTIFY summaryChanged)
+public:
+    enum Roles { NameRole = Qt::UserRole + 1, StatusRole, ErrorRole };
+    explicit BatchConverter(QObject* parent = nullptr);
+    ~BatchConverter();
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    Q_INVOKABLE void setSourceFolder(const QUrl& folder);
+    Q_INVOKABLE void convert(const QUrl& destinationFolder);
+    Q_INVOKABLE void cancel();
+    bool isBusy() const { return m_running > 0; }
+    QString getSummary() const { return m_summary; }
+signals:
+    void busyChanged();
+    void summaryChanged();
+private:
+    void convertFile(const int row, const QString& inFile, const QString& outFile);
+    void fileStarted(const int row);
+    void fileFinished(const int row, const BatchStatus status, const QString& error);
+    void updateSummary();
+    QString m_sourceFolder;
+    std::vector<BatchFile> m_files;
+    QThreadPool m_pool;
+    CancellationToken m_cancel;
+    int m_running { 0 };                // files queued or running in the pool
+    QElapsedTimer m_timer;
+    QString m_summary;
+};
+
+#endif // BATCHCONVERTER_H
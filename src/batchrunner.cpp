@@ -0,0 +1,206 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <algorithm>
+#include <thread>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QtDebug>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+#include "batchrunner.h"
+#include "journal.h"
+
+// the amount of worker stderr output kept to explain a failure
+static const int MAX_ERROR_OUTPUT = 4096;
+
+
+//---------------------------------------------------------
+// BatchRunner - constructor
+//---------------------------------------------------------
+
+BatchRunner::BatchRunner(const QString& workerProgram, const QStringList& filenames, const QStringList& workerArguments, const WorkerLimits& limits)
+    : m_workerProgram(workerProgram), m_filenames(filenames), m_workerArguments(workerArguments), m_limits(limits)
+{
+
+}
+
+
+//---------------------------------------------------------
+// run - convert all files, returns when the last worker has finished
+// the failures are sorted by file name
+//---------------------------------------------------------
+
+void BatchRunner::run()
+{
+    const int threads = std::max(1, std::min(m_limits.m_jobs, static_cast<int>(m_filenames.size())));
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(&BatchRunner::workerThread, this);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::sort(m_failures.begin(), m_failures.end(),
+              [](const BatchFailure& f1, const BatchFailure& f2) { return f1.m_filename < f2.m_filename; });
+
+    qDebug()
+        << "batch files" << m_filenames.size()
+        << "failures" << m_failures.size()
+        ;
+}
+
+
+//---------------------------------------------------------
+// workerThread - run workers for the remaining files one at a time
+//---------------------------------------------------------
+
+void BatchRunner::workerThread()
+{
+    const int count = static_cast<int>(m_filenames.size());
+    for (int i = m_next++; i < count; i = m_next++) {
+        const QString& filename = m_filenames.at(i);
+        const JournalEntry fingerprint = m_journal ? ConversionJournal::fingerprint(filename) : JournalEntry();
+        const BatchFailure res = runWorker(filename);
+        if (m_journal) {
+            m_journal->record(filename, fingerprint, res.m_reason.isEmpty());
+        }
+        if (!res.m_reason.isEmpty()) {
+            qWarning() << res.m_filename << res.m_reason;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_failures.push_back(res);
+        }
+    }
+}
+
+
+//---------------------------------------------------------
+// runWorker - convert filename in a worker process
+// the worker's debug output is disabled, its warnings are
+// kept to explain a failure
+//---------------------------------------------------------
+
+BatchFailure BatchRunner::runWorker(const QString& filename) const
+{
+    BatchFailure res;
+    res.m_filename = filename;
+
+    QProcess worker;
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("QT_LOGGING_RULES", "*.debug=false");
+    worker.setProcessEnvironment(env);
+    worker.setStandardOutputFile(QProcess::nullDevice());
+#if defined(Q_OS_UNIX)
+    // runs in the child between fork and exec
+    // the CPU time limit is a backstop in case the watchdog below fails
+    const rlim_t memoryLimit = static_cast<rlim_t>(m_limits.m_memoryLimit) * 1024 * 1024;
+    const rlim_t cpuLimit = static_cast<rlim_t>(m_limits.m_timeout) + 1;
+    const bool timeLimited = m_limits.m_timeout > 0;
+    worker.setChildProcessModifier([memoryLimit, cpuLimit, timeLimited]() {
+        if (memoryLimit > 0) {
+            const struct rlimit limit { memoryLimit, memoryLimit };
+            ::setrlimit(RLIMIT_AS, &limit);
+        }
+        if (timeLimited) {
+            const struct rlimit limit { cpuLimit, cpuLimit };
+            ::setrlimit(RLIMIT_CPU, &limit);
+        }
+    });
+#endif
+
+    QElapsedTimer timer;
+    timer.start();
+    QStringList arguments = m_workerArguments;
+    arguments.append(filename);
+    worker.start(m_workerProgram, arguments);
+    if (!worker.waitForStarted()) {
+        res.m_reason = "cannot start worker process";
+        return res;
+    }
+
+    // the watchdog: poll the worker, draining stderr to prevent it from blocking
+    const qint64 timeout = static_cast<qint64>(m_limits.m_timeout) * 1000;
+    QByteArray errors;
+    bool timedOut = false;
+    while (worker.state() != QProcess::NotRunning) {
+        worker.waitForFinished(100);
+        errors += worker.readAllStandardError();
+        if (errors.size() > MAX_ERROR_OUTPUT)
+            errors = errors.right(MAX_ERROR_OUTPUT);
+        if (timeout > 0 && timer.elapsed() > timeout && worker.state() != QProcess::NotRunning) {
+            worker.kill();
+            worker.waitForFinished();
+            timedOut = true;
+        }
+    }
+    errors += worker.readAllStandardError();
+    res.m_elapsed = timer.elapsed();
+
+    if (timedOut) {
+        res.m_reason = QString("timeout after %1 s").arg(m_limits.m_timeout);
+    }
+    else if (worker.exitStatus() == QProcess::CrashExit) {
+        res.m_reason = m_limits.m_memoryLimit > 0 || m_limits.m_timeout > 0
+                       ? "worker crashed or exceeded its resource limits"
+                       : "worker crashed";
+    }
+    else if (worker.exitCode() != 0) {
+        const QStringList lines = QString::fromLocal8Bit(errors).trimmed().split('\n');
+        res.m_reason = lines.isEmpty() || lines.last().isEmpty()
+                       ? QString("worker exit code %1").arg(worker.exitCode())
+                       : lines.last().trimmed();
+    }
+    return res;
+}
+
+
+//---------------------------------------------------------
+// reportField - a failure report field with the characters
+// that would break the tab separated layout replaced by spaces
+//---------------------------------------------------------
+
+static QString reportField(QString field)
+{
+    return field.replace('\t', ' ').replace('\n', ' ').replace('\r', ' ');
+}
+
+
+//---------------------------------------------------------
+// writeFailureReport - write the failures as tab separated values
+// file name, reason and elapsed time in milliseconds
+//---------------------------------------------------------
+
+bool BatchRunner::writeFailureReport(const QString& filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "cannot open" << filename << file.errorString();
+        return false;
+    }
+    file.write("file\treason\tmilliseconds\n");
+    for (const auto& failure : m_failures) {
+        file.write(QString("%1\t%2\t%3\n").arg(reportField(failure.m_filename), reportField(failure.m_reason)).arg(failure.m_elapsed).toLocal8Bit());
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <QStringList>
+
+class ConversionJournal;
+
+
+//---------------------------------------------------------
+// the resource budget of the worker processes
+//---------------------------------------------------------
+
+struct WorkerLimits
+{
+    int     m_jobs              { 1 };      // number of concurrent worker processes
+    int     m_timeout           { 0 };      // wall-clock limit per file in seconds, 0 is unlimited
+    int     m_memoryLimit       { 0 };      // address space limit per worker in MiB, 0 is unlimited
+};
+
+
+//---------------------------------------------------------
+// a file the batch runner could not convert
+//---------------------------------------------------------
+
+struct BatchFailure
+{
+    QString m_filename;
+    QString m_reason;                       // empty if converted successfully
+    qint64  m_elapsed           { 0 };      // milliseconds
+};
+
+
+//---------------------------------------------------------
+// the batch runner converts each file in a separate worker process,
+// running workerProgram with the worker arguments and the file name
+// at most m_jobs workers run at the same time
+// a worker exceeding the timeout is killed, the memory limit is
+// enforced by the kernel (Unix only)
+// failing files are collected and the batch continues with the next file
+// the outcome of each file is recorded in the optional journal
+//---------------------------------------------------------
+
+class BatchRunner
+{
+public:
+    BatchRunner(const QString& workerProgram, const QStringList& filenames, const QStringList& workerArguments, const WorkerLimits& limits);
+    void run();
+    void setJournal(ConversionJournal* journal) { m_journal = journal; }
+    const std::vector<BatchFailure>& failures() const { return m_failures; }
+    bool writeFailureReport(const QString& filename) const;
+private:
+    void workerThread();
+    BatchFailure runWorker(const QString& filename) const;
+    const QString m_workerProgram;
+    const QStringList m_filenames;
+    const QStringList m_workerArguments;
+    const WorkerLimits m_limits;
+    ConversionJournal* m_journal { nullptr };
+    std::atomic<int> m_next { 0 };          // index of the next file to convert
+    std::mutex m_mutex;                     // protects m_failures
+    std::vector<BatchFailure> m_failures;
+};
+
+#endif // BATCHRUNNER_H
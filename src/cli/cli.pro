@@ -0,0 +1,12 @@
+QT       = core
+
+CONFIG  += c++11
+
+TARGET   = Enc2MusicXML-cli
+TEMPLATE = app
+CONFIG  += console
+CONFIG  -= app_bundle
+
+include(../app.pri)
+
+SOURCES += main.cpp
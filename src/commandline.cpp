@@ -0,0 +1,604 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QtDebug>
+
+#include "analysisfile.h"
+#include "batchrunner.h"
+#include "commandline.h"
+#include "encfile.h"
+#include "encreader.h"
+#include "folderwatcher.h"
+#include "journal.h"
+#include "mxmlconverter.h"
+#include "pipeline.h"
+#include "textfile.h"
+
+const QString applicationName { "Enc2MusicXML" };
+const QString applicationVersion { "0.7" };
+
+
+//---------------------------------------------------------
+// addCommandLineOptions - add the options for analysing, dumping and converting
+//---------------------------------------------------------
+
+void addCommandLineOptions(QCommandLineParser& clp)
+{
+    clp.setApplicationDescription("Enc2MusicXML converts Encore files to MusicXML.");
+    clp.addHelpOption();
+    clp.addVersionOption();
+    clp.addOptions({
+        {{"a", "analyse"},
+         QCoreApplication::translate("main", "Analyse file(s).")},
+        {{"d", "dump"},
+         QCoreApplication::translate("main", "Dump file(s). Similar to enc2ly's --dump option.")},
+        {{"m", "convert-to-MusicXML"},
+         QCoreApplication::translate("main", "Convert file(s) to MusicXML format.")},
+        {"prefetch",
+         QCoreApplication::translate("main", "Number of input files to read ahead when converting (default 4)."),
+         QCoreApplication::translate("main", "count"), "4"},
+        {"timewise",
+         QCoreApplication::translate("main", "Write score-timewise instead of score-partwise MusicXML.")},
+        {"progress",
+         QCoreApplication::translate("main", "Report the MusicXML conversion progress of each file on stderr.")},
+        {"jobs",
+         QCoreApplication::translate("main", "Convert each file in a separate worker process, running <count> workers at a time. All outputs must be written to files. With --watch, the number of files converted at the same time."),
+         QCoreApplication::translate("main", "count")},
+        {"timeout",
+         QCoreApplication::translate("main", "With --jobs, stop a worker converting a single file for longer than <seconds>."),
+         QCoreApplication::translate("main", "seconds")},
+        {"memory-limit",
+         QCoreApplication::translate("main", "With --jobs, limit the memory of each worker to <MiB> megabytes (Unix only)."),
+         QCoreApplication::translate("main", "MiB")},
+        {"failure-report",
+         QCoreApplication::translate("main", "With --jobs, write the files that failed and the reasons to <file>."),
+         QCoreApplication::translate("main", "file")},
+        {"files-from",
+         QCoreApplication::translate("main", "Read the input files from <list>, separated by newlines or NUL characters. Use - for stdin."),
+         QCoreApplication::translate("main", "list")},
+        {"shard",
+         QCoreApplication::translate("main", "Convert only shard <i/n> of the input files (0 <= i < n), selected by a hash of each file's path."),
+         QCoreApplication::translate("main", "i/n")},
+        {"watch",
+         QCoreApplication::translate("main", "Watch <folder> and convert the Encore files created or changed in it to MusicXML until interrupted."),
+         QCoreApplication::translate("main", "folder")},
+        {"watch-output",
+         QCoreApplication::translate("main", "With --watch, write the MusicXML files to <folder> instead of next to the Encore files."),
+         QCoreApplication::translate("main", "folder")},
+        {"watch-debounce",
+         QCoreApplication::translate("main", "With --watch, convert a file once it did not change for <ms> milliseconds (default 500)."),
+         QCoreApplication::translate("main", "ms"), "500"},
+        {"journal",
+         QCoreApplication::translate("main", "Record the converted files in <file> and skip the files converted before that did not change since. All outputs must be written to files."),
+         QCoreApplication::translate("main", "file")},
+        {"analysis-output",
+         QCoreApplication::translate("main", "Write the analysis to <file> instead of stdout. %1 is replaced by the input file's base name."),
+         QCoreApplication::translate("main", "file")},
+        {"dump-output",
+         QCoreApplication::translate("main", "Write the dump to <file> instead of stdout. %1 is replaced by the input file's base name."),
+         QCoreApplication::translate("main", "file")},
+        {"musicxml-output",
+         QCoreApplication::translate("main", "Write the MusicXML to <file> instead of stdout. %1 is replaced by the input file's base name."),
+         QCoreApplication::translate("main", "file")},
+        });
+}
+
+
+//---------------------------------------------------------
+// the outputs that can be written for an Encore file
+//---------------------------------------------------------
+
+enum class OutputType { ANALYSIS, DUMP, MUSICXML };
+
+struct OutputRequest
+{
+    OutputType m_type;
+    QString m_destination;  // empty for stdout
+};
+
+
+//---------------------------------------------------------
+// requestedOutputs - the outputs selected by -a, -d, -m and their destinations
+// setting a destination also selects the output
+//---------------------------------------------------------
+
+static std::vector<OutputRequest> requestedOutputs(const QCommandLineParser& clp)
+{
+    std::vector<OutputRequest> res;
+    if (clp.isSet("a") || clp.isSet("analysis-output"))
+        res.push_back({ OutputType::ANALYSIS, clp.value("analysis-output") });
+    if (clp.isSet("d") || clp.isSet("dump-output"))
+        res.push_back({ OutputType::DUMP, clp.value("dump-output") });
+    if (clp.isSet("m") || clp.isSet("musicxml-output"))
+        res.push_back({ OutputType::MUSICXML, clp.value("musicxml-output") });
+    return res;
+}
+
+
+//---------------------------------------------------------
+// parseShard - parse "i/n" into index and count
+// returns false unless 0 <= index < count
+//---------------------------------------------------------
+
+static bool parseShard(const QString& shard, int& index, int& count)
+{
+    const QStringList parts = shard.split('/');
+    if (parts.size() != 2)
+        return false;
+    bool indexOk = false;
+    bool countOk = false;
+    index = parts.at(0).toInt(&indexOk);
+    count = parts.at(1).toInt(&countOk);
+    return indexOk && countOk && count > 0 && index >= 0 && index < count;
+}
+
+
+//---------------------------------------------------------
+// isNumberValid - check that option, if set, is an integer >= minimum
+//---------------------------------------------------------
+
+static bool isNumberValid(const QCommandLineParser& clp, const QString& option, const int minimum)
+{
+    if (!clp.isSet(option))
+        return true;
+    bool ok = false;
+    const int value = clp.value(option).toInt(&ok);
+    if (!ok || value < minimum) {
+        qWarning() << "invalid" << option << clp.value(option) << "expected an integer >=" << minimum;
+        return false;
+    }
+    return true;
+}
+
+
+//---------------------------------------------------------
+// hasCommandLineAction - true if at least one output is requested
+// or a folder is to be watched
+//---------------------------------------------------------
+
+bool hasCommandLineAction(const QCommandLineParser& clp)
+{
+    return !requestedOutputs(clp).empty() || clp.isSet("watch");
+}
+
+
+//---------------------------------------------------------
+// isCommandLineValid - check the combination of options and arguments
+// allowNoAction permits running without -a, -d or -m and without files
+//---------------------------------------------------------
+
+bool isCommandLineValid(const QCommandLineParser& clp, const bool allowNoAction)
+{
+    if (clp.isSet("h"))
+        return false;
+    if (clp.isSet("shard")) {
+        int index = 0;
+        int count = 0;
+        if (!parseShard(clp.value("shard"), index, count)) {
+            qWarning() << "invalid shard" << clp.value("shard") << "expected i/n with 0 <= i < n";
+            return false;
+        }
+    }
+    if (!isNumberValid(clp, "jobs", 1) || !isNumberValid(clp, "timeout", 0) || !isNumberValid(clp, "memory-limit", 0))
+        return false;
+    if (clp.isSet("watch")) {
+        if (!clp.positionalArguments().isEmpty() || !requestedOutputs(clp).empty() || clp.isSet("prefetch")) {
+            qWarning() << "--watch cannot be combined with input files, other outputs or --prefetch";
+            return false;
+        }
+        return true;
+    }
+    if (hasCommandLineAction(clp)) {
+        // the number of files in a list is not known yet, assume several
+        const auto files = clp.isSet("files-from") ? 2 : clp.positionalArguments().count();
+        int toStdout = 0;
+        if (clp.isSet("jobs") && clp.isSet("prefetch")) {
+            // each worker converts a single file
+            qWarning() << "--prefetch cannot be combined with --jobs";
+            return false;
+        }
+        if (clp.isSet("jobs") && clp.isSet("progress")) {
+            // the workers' stderr is only kept to explain a failure
+            qWarning() << "--progress cannot be combined with --jobs";
+            return false;
+        }
+        for (const auto& output : requestedOutputs(clp)) {
+            if (clp.isSet("jobs") && !output.m_destination.contains("%1")) {
+                qWarning() << "with --jobs every output must be written to a file containing %1";
+                return false;
+            }
+            if (clp.isSet("journal") && output.m_destination.isEmpty()) {
+                qWarning() << "with --journal every output must be written to a file";
+                return false;
+            }
+            if (output.m_destination.isEmpty())
+                ++toStdout;
+            else if (files > 1 && !output.m_destination.contains("%1")) {
+                qWarning() << "destination" << output.m_destination << "must contain %1 when converting multiple files";
+                return false;
+            }
+        }
+        if (toStdout > 1) {
+            qWarning() << "only one output can be written to stdout";
+            return false;
+        }
+        return files >= 1;
+    }
+    return allowNoAction && clp.positionalArguments().count() == 0;
+}
+
+
+//---------------------------------------------------------
+// outputFileName - the file the output for the Encore file filename is written to
+//---------------------------------------------------------
+
+static QString outputFileName(const OutputRequest& output, const QString& filename)
+{
+    return output.m_destination.contains("%1")
+           ? output.m_destination.arg(QFileInfo(filename).completeBaseName())
+           : output.m_destination;
+}
+
+
+//---------------------------------------------------------
+// hasOutputCollisions - check if two outputs would be written to the same
+// file, either for two input files (%1, the base name, is the same for
+// equally named files in different directories) or for two output types
+//---------------------------------------------------------
+
+static bool hasOutputCollisions(const std::vector<OutputRequest>& outputs, const QStringList& files)
+{
+    bool res = false;
+    std::map<QString, QString> written;         // output file -> input file
+    for (const auto& output : outputs) {
+        if (output.m_destination.isEmpty())
+            continue;
+        for (const auto& s : files) {
+            const QString outName = outputFileName(output, s);
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+            const auto key = QFileInfo(outName).absoluteFilePath().toLower();
+#else
+            const auto key = QFileInfo(outName).absoluteFilePath();
+#endif
+            const auto it = written.emplace(key, s);
+            if (!it.second) {
+                qWarning() << it.first->second << "and" << s << "would both be written to" << outName;
+                res = true;
+            }
+        }
+    }
+    return res;
+}
+
+
+//---------------------------------------------------------
+// writeOutput - write one output for the Encore file filename
+// the MusicXML converter takes over the note connections nc
+// returns false if the output file cannot be opened
+//---------------------------------------------------------
+
+static bool writeOutput(const OutputRequest& output, const QString& filename, const EncFile& ef, NoteConnector& nc, const bool timewise, const bool progress)
+{
+    QFile outFile;
+    if (output.m_destination.isEmpty()) {
+        outFile.open(stdout, QFile::WriteOnly);
+    }
+    else {
+        outFile.setFileName(outputFileName(output, filename));
+        if (!outFile.open(QIODevice::WriteOnly)) {
+            qWarning() << "cannot open" << outFile.fileName() << outFile.errorString();
+            return false;
+        }
+    }
+
+    switch (output.m_type) {
+    case OutputType::ANALYSIS: {
+        AnalysisFile af(ef, &outFile);
+        af.write();
+        break;
+    }
+    case OutputType::DUMP: {
+        TextFile tf(ef, &outFile);
+        tf.write();
+        break;
+    }
+    case OutputType::MUSICXML: {
+        MxmlConverter mc(ef, std::move(nc), &outFile);
+        ProgressReporter reporter(filename);
+        if (progress)
+            mc.setObserver(&reporter);
+        mc.convertEncToMxml(timewise);
+        break;
+    }
+    }
+    return true;
+}
+
+
+//---------------------------------------------------------
+// writeOutputs - parse each file once and write all requested outputs
+// reading, parsing and writing overlap in a conversion pipeline,
+// the writers only read the parsed file and run concurrently
+// the outcome is recorded in journal (if not null)
+// returns the number of files that could not be read or written
+//---------------------------------------------------------
+
+static int writeOutputs(const QCommandLineParser& clp, const QStringList& files, ConversionJournal* journal)
+{
+    const auto outputs = requestedOutputs(clp);
+    const bool timewise = clp.isSet("timewise");
+    const bool progress = clp.isSet("progress");
+    const int prefetch = clp.value("prefetch").toInt();
+    ConversionPipeline pipeline(files, prefetch > 0 ? prefetch : 1);
+    pipeline.setJournal(journal);
+    pipeline.setWriter([&](PipelineItem& item) {
+        std::vector<char> written(outputs.size(), 0);
+        std::vector<std::thread> writers;
+        for (size_t i = 1; i < outputs.size(); ++i) {
+            writers.emplace_back([&, i]() { written.at(i) = writeOutput(outputs.at(i), item.m_filename, *item.m_ef, *item.m_nc, timewise, progress); });
+        }
+        written.at(0) = writeOutput(outputs.at(0), item.m_filename, *item.m_ef, *item.m_nc, timewise, progress);
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        return std::all_of(written.begin(), written.end(), [](const char w) { return w != 0; });
+    });
+    pipeline.run();
+    return pipeline.stats().m_failedFiles;
+}
+
+
+//---------------------------------------------------------
+// workerArguments - the options passed to a batch worker process
+// each worker writes the requested outputs for a single file
+//---------------------------------------------------------
+
+static QStringList workerArguments(const QCommandLineParser& clp)
+{
+    QStringList res;
+    for (const auto& output : requestedOutputs(clp)) {
+        switch (output.m_type) {
+        case OutputType::ANALYSIS: res.append("--analysis-output"); break;
+        case OutputType::DUMP:     res.append("--dump-output"); break;
+        case OutputType::MUSICXML: res.append("--musicxml-output"); break;
+        }
+        res.append(output.m_destination);
+    }
+    if (clp.isSet("timewise"))
+        res.append("--timewise");
+    return res;
+}
+
+
+//---------------------------------------------------------
+// workerProgram - the executable run by the batch workers
+// the console-only version, which starts faster and needs no display,
+// either this executable, next to it or in its build directory (cli)
+// falls back to this executable if it cannot be found
+//---------------------------------------------------------
+
+static QString workerProgram()
+{
+    const QString consoleName = "Enc2MusicXML-cli";
+    const QFileInfo self(QCoreApplication::applicationFilePath());
+    if (self.completeBaseName() == consoleName)
+        return self.absoluteFilePath();
+#if defined(Q_OS_WIN)
+    const QString fileName = consoleName + ".exe";
+#else
+    const QString fileName = consoleName;
+#endif
+    const QDir dir = self.dir();
+    for (const auto& path : { dir.filePath(fileName), dir.filePath("cli/" + fileName) }) {
+        const QFileInfo worker(path);
+        if (worker.isFile() && worker.isExecutable())
+            return worker.absoluteFilePath();
+    }
+    qWarning() << "cannot find" << fileName << "next to" << self.absoluteFilePath() << "- the workers run the GUI executable";
+    return self.absoluteFilePath();
+}
+
+
+//---------------------------------------------------------
+// runBatch - convert the files in isolated worker processes
+// the outcome is recorded in journal (if not null)
+// returns the number of files that failed
+//---------------------------------------------------------
+
+static int runBatch(const QCommandLineParser& clp, const QStringList& files, ConversionJournal* journal)
+{
+    WorkerLimits limits;
+    limits.m_jobs = clp.value("jobs").toInt();
+    limits.m_timeout = clp.value("timeout").toInt();
+    limits.m_memoryLimit = clp.value("memory-limit").toInt();
+
+    BatchRunner runner(workerProgram(), files, workerArguments(clp), limits);
+    runner.setJournal(journal);
+    runner.run();
+    if (clp.isSet("failure-report"))
+        runner.writeFailureReport(clp.value("failure-report"));
+    return static_cast<int>(runner.failures().size());
+}
+
+
+//---------------------------------------------------------
+// readFileList - read the file names in list (stdin if "-")
+// names are separated by NUL characters if the list contains any,
+// else by newlines
+//---------------------------------------------------------
+
+static bool readFileList(const QString& list, QStringList& files)
+{
+    QFile file;
+    bool opened = false;
+    if (list == "-") {
+        opened = file.open(stdin, QIODevice::ReadOnly);
+    }
+    else {
+        file.setFileName(list);
+        opened = file.open(QIODevice::ReadOnly);
+    }
+    if (!opened) {
+        qWarning() << "cannot open file list" << list << file.errorString();
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    const char separator = data.contains('\0') ? '\0' : '\n';
+    for (const auto& name : data.split(separator)) {
+        const QByteArray trimmed = separator == '\n' && name.endsWith('\r') ? name.left(name.size() - 1) : name;
+        if (!trimmed.isEmpty())
+            files.append(QFile::decodeName(trimmed));
+    }
+    return true;
+}
+
+
+//---------------------------------------------------------
+// pathHash - a hash of path that is the same on every machine and run
+// (64-bit FNV-1a of the UTF-8 encoded path, unlike qHash it is not seeded)
+//---------------------------------------------------------
+
+static quint64 pathHash(const QString& path)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (const char c : path.toUtf8()) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+//---------------------------------------------------------
+// inputFiles - the files given as arguments and in the --files-from list,
+// restricted to the files in this --shard
+// each file is in exactly one shard, determined by its path as given:
+// all nodes must be given the same paths
+//---------------------------------------------------------
+
+static bool inputFiles(const QCommandLineParser& clp, QStringList& files)
+{
+    QStringList all = clp.positionalArguments();
+    if (clp.isSet("files-from") && !readFileList(clp.value("files-from"), all))
+        return false;
+
+    if (!clp.isSet("shard")) {
+        files = all;
+        return true;
+    }
+    int index = 0;
+    int count = 1;
+    parseShard(clp.value("shard"), index, count);
+    for (const auto& s : all) {
+        if (pathHash(s) % static_cast<quint64>(count) == static_cast<quint64>(index))
+            files.append(s);
+    }
+    qInfo() << "shard" << index << "of" << count << "selected" << files.size() << "of" << all.size() << "files";
+    return true;
+}
+
+
+//---------------------------------------------------------
+// outdatedFiles - the files not converted before according to journal,
+// changed since or with a missing output
+//---------------------------------------------------------
+
+static QStringList outdatedFiles(const QCommandLineParser& clp, const QStringList& files, const ConversionJournal& journal)
+{
+    const auto outputs = requestedOutputs(clp);
+    QStringList res;
+    for (const auto& s : files) {
+        QStringList outputFiles;
+        for (const auto& output : outputs) {
+            outputFiles.append(outputFileName(output, s));
+        }
+        if (!journal.isUpToDate(s, outputFiles)) {
+            res.append(s);
+        }
+    }
+    qInfo() << "journal: skipping" << files.size() - res.size() << "up to date files";
+    return res;
+}
+
+
+//---------------------------------------------------------
+// runWatch - convert the files arriving in the watched folder
+// returns only if the folder cannot be watched or the application quits
+// the number of concurrent conversions is --jobs (default: one per core)
+//---------------------------------------------------------
+
+static int runWatch(const QCommandLineParser& clp)
+{
+    FolderWatcher watcher(clp.value("watch"), clp.value("watch-output"));
+    const int jobs = clp.isSet("jobs") ? clp.value("jobs").toInt() : QThread::idealThreadCount();
+    watcher.setJobs(std::max(1, jobs));
+    watcher.setDebounce(std::max(0, clp.value("watch-debounce").toInt()));
+    watcher.setTimewise(clp.isSet("timewise"));
+    if (!watcher.start()) {
+        return 1;
+    }
+    return QCoreApplication::exec();
+}
+
+
+//---------------------------------------------------------
+// runCommandLine - analyse, dump and/or convert the files given
+// returns 1 if any file could not be converted
+//---------------------------------------------------------
+
+int runCommandLine(const QCommandLineParser& clp)
+{
+    if (clp.isSet("watch")) {
+        return runWatch(clp);
+    }
+
+    const auto outputs = requestedOutputs(clp);
+    QStringList files;
+    if (!inputFiles(clp, files) || hasOutputCollisions(outputs, files)) {
+        return 1;
+    }
+    ConversionJournal journal;
+    const bool useJournal = clp.isSet("journal");
+    if (useJournal) {
+        if (!journal.open(clp.value("journal"))) {
+            return 1;
+        }
+        files = outdatedFiles(clp, files, journal);
+    }
+
+    int failures = 0;
+    if (clp.isSet("jobs")) {
+        failures = runBatch(clp, files, useJournal ? &journal : nullptr);
+    }
+    else if (!outputs.empty()) {
+        failures = writeOutputs(clp, files, useJournal ? &journal : nullptr);
+    }
+
+    return failures > 0 ? 1 : 0;
+}
@@ -3,62 +3,89 @@
 
 #include "converter.h"
 #include "encfile.h"
+#include "encreader.h"
 #include "mxmlconverter.h"
 
-//---------------------------------------------------------
-// read_file - read an Encore file into ef
-//---------------------------------------------------------
-
-// copied from main.cpp
-// TODO: remove duplicated code
-
-static QString read_file(const QString& filename, EncFile& ef)
-{
-    qDebug() << "processing file" << filename;
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return("cannot open Encore file");
-    }
-    QByteArray fileData = file.readAll();
-    file.close();
-
-    // Detectar formato ZBOT (cifrado) - magic "ZBOT" = 0x5A424F54
-    if (fileData.size() >= 4 && fileData.startsWith("ZBOT")) {
-        qWarning() << "ERROR: ZBOT format detected.";
-        qWarning() << "ZBOT files are encrypted and cannot be converted directly.";
-        qWarning() << "Please convert the file to SCOW format using Encore 5.x:";
-        qWarning() << "  1. Open the .enc file in Encore 5.x on Windows";
-        qWarning() << "  2. Save it (the new version will be in SCOW format)";
-        qWarning() << "  3. Use Enc2MusicXML with the converted file";
-        return "ERROR: ZBOT format detected.";
-    }
-
-    QDataStream data(&fileData, QIODevice::ReadOnly);
-    if (ef.read(data)) {
-        // TODO: could EncFile return more detailed errors ?
-        return "";
-    }
-    else {
-        return "error reading Encore file";
+Converter::~Converter(){
+    if (m_worker) {
+        m_cancel.cancel();
+        m_worker->wait();
+        delete m_worker;
     }
 }
 
+// start the conversion in a worker thread and return immediately
+// progress is reported through progressChanged, the outcome through resultChanged
 void Converter::convert(const QUrl& inUrl, const QUrl& outUrl){
     qDebug("Converter: string inUrl %s outUrl %s", qPrintable(inUrl.toString()), qPrintable(outUrl.toString()));
     qDebug("Converter: displaystring inUrl %s outUrl %s", qPrintable(inUrl.toDisplayString()), qPrintable(outUrl.toDisplayString()));
     qDebug("Converter: localfile inUrl %s outUrl %s", qPrintable(inUrl.toLocalFile()), qPrintable(outUrl.toLocalFile()));
-    EncFile ef;
-    m_result = read_file(inUrl.toLocalFile(), ef);
-    if (m_result != "") {
+    if (m_worker) {
         return;
     }
-    QFile outFile(outUrl.toLocalFile());
-    if (!outFile.open(QFile::WriteOnly)) {
-        m_result = "cannot open MusicXML file";
+    const QString inFile = inUrl.toLocalFile();
+    const QString outFileName = outUrl.toLocalFile();
+    m_cancel.reset();
+    m_lastPercent = -1;
+    setProgress(0, "reading Encore file");
+    m_worker = QThread::create([this, inFile, outFileName]() {
+        EncFile ef;
+        QString result = readEncFile(inFile, ef);
+        if (result == "") {
+            QFile outFile(outFileName);
+            if (!outFile.open(QFile::WriteOnly)) {
+                result = "cannot open MusicXML file";
+            }
+            else {
+                MxmlConverter mf(ef, &outFile);
+                mf.setObserver(this);
+                mf.setCancellationToken(&m_cancel);
+                if (mf.convertEncToMxml()) {
+                    // TODO: could MxmlConverter fail ? If so, report error.
+                    result = "success";
+                }
+                else {
+                    outFile.remove();
+                    result = "cancelled";
+                }
+            }
+        }
+        QMetaObject::invokeMethod(this, [this, result]() { finished(result); }, Qt::QueuedConnection);
+    });
+    m_worker->start();
+    emit busyChanged();
+}
+
+// called in the worker thread, forwards at most one update per percent to the GUI thread
+void Converter::measureConverted(const ConversionProgress& progress){
+    const auto done = progress.m_measuresDone;
+    const auto total = progress.m_measuresTotal;
+    const int percent = total > 0 ? static_cast<int>(100 * done / total) : 100;
+    if (percent == m_lastPercent) {
         return;
     }
-    MxmlConverter mf(ef, &outFile);
-    mf.convertEncToMxml();
-    // TODO: could MxmlConverter fail ? If so, report error.
-    m_result = "success";
+    m_lastPercent = percent;
+    const QString text = QString("part %1 of %2, measure %3 of %4")
+                         .arg(progress.m_partNr).arg(progress.m_partCount)
+                         .arg(progress.m_measureNr + 1).arg(progress.m_measureCount);
+    QMetaObject::invokeMethod(this, [this, percent, text]() { setProgress(percent / 100.0, text); }, Qt::QueuedConnection);
+}
+
+// called in the GUI thread when the worker is done
+void Converter::finished(const QString& result){
+    m_worker->wait();
+    delete m_worker;
+    m_worker = nullptr;
+    m_result = result;
+    if (result == "success") {
+        setProgress(1, "done");
+    }
+    emit busyChanged();
+    emit resultChanged(m_result);
+}
+
+void Converter::setProgress(const double progress, const QString& text){
+    m_progress = progress;
+    m_progressText = text;
+    emit progressChanged();
 }
@@ -2,18 +2,40 @@
 #define CONVERTER_H
 
 #include <QObject>
+#include <QThread>
 #include <QUrl>
 
-class Converter : public QObject{
+#include "mxmlconverter.h"
+
+class Converter : public QObject, public ConversionObserver{
     Q_OBJECT
+    Q_PROPERTY(bool busy READ isBusy NOTIFY busyChanged)
+    Q_PROPERTY(double progress READ getProgress NOTIFY progressChanged)
+    Q_PROPERTY(QString progressText READ getProgressText NOTIFY progressChanged)
 public:
     explicit Converter (QObject* parent = 0) : QObject(parent) {}
+    ~Converter();
     Q_INVOKABLE void convert(const QUrl& inUrl, const QUrl& outUrl);
+    Q_INVOKABLE void cancel() { m_cancel.cancel(); }
     Q_INVOKABLE QString getResult() const { return m_result; }
+    bool isBusy() const { return m_worker != nullptr; }
+    double getProgress() const { return m_progress; }
+    QString getProgressText() const { return m_progressText; }
+    // ConversionObserver, called from the worker thread
+    void measureConverted(const ConversionProgress& progress) override;
 signals:
+    void busyChanged();
+    void progressChanged();
     void resultChanged(QString newValue);
 private:
+    void finished(const QString& result);
+    void setProgress(const double progress, const QString& text);
     QString m_result;
+    QThread* m_worker { nullptr };
+    CancellationToken m_cancel;
+    int m_lastPercent { -1 };   // worker thread only: limits the number of progress updates
+    double m_progress { 0 };
+    QString m_progressText;
 };
 
-#endif // CONVERTER_H
\ No newline at end of file
+#endif // CONVERTER_H
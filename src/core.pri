@@ -0,0 +1,20 @@
+# parser and converter sources, shared by the applications and the library
+# depends on QtCore only, the parser itself does not depend on Qt
+
+include($$PWD/parser.pri)
+
+SOURCES += $$PWD/encreader.cpp \
+           $$PWD/mxmlconverter.cpp \
+           $$PWD/mxmlwriter.cpp \
+           $$PWD/noteconnector.cpp \
+           $$PWD/notevalues.cpp \
+           $$PWD/scoretimeline.cpp \
+           $$PWD/voicetimeline.cpp
+
+HEADERS += $$PWD/encreader.h \
+           $$PWD/mxmlconverter.h \
+           $$PWD/mxmlwriter.h \
+           $$PWD/noteconnector.h \
+           $$PWD/notevalues.h \
+           $$PWD/scoretimeline.h \
+           $$PWD/voicetimeline.h
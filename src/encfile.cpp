@@ -22,54 +22,190 @@
 // implementation of the classes representing an Encore file
 //---------------------------------------------------------
 
-#include <QtDebug>
-#include <QIODevice>
-
+#include <atomic>
 #include <map>
 #include <algorithm>
+#include <sstream>
+#include <type_traits>
 
 #include "encfile.h"
 
 
 //---------------------------------------------------------
-// hexString - convert a 64-bit integer into a QString
+// the installed log handler and threshold
+//---------------------------------------------------------
+
+static std::atomic<EncLogHandler> logHandler { nullptr };
+static std::atomic<EncLogLevel> logThreshold { EncLogLevel::DEBUG };
+
+void setEncLogHandler(EncLogHandler handler, const EncLogLevel threshold)
+{
+    logThreshold = threshold;
+    logHandler = handler;
+}
+
+
+//---------------------------------------------------------
+// EncLog - collect a single message and pass it to the
+// log handler when done, used like encDebug(): items are
+// separated by spaces and strings are quoted
+// does nothing when no handler is interested in the message
+//---------------------------------------------------------
+
+namespace {
+
+class EncLog
+{
+public:
+    explicit EncLog(const EncLogLevel level)
+        : m_level(level), m_handler(level >= logThreshold ? logHandler.load() : nullptr) {}
+    EncLog(const EncLog&) = delete;
+    EncLog& operator=(const EncLog&) = delete;
+    ~EncLog() { if (m_handler) m_handler(m_level, m_stream.str()); }
+    EncLog& operator<<(const char* s) { if (m_handler) separator() << s; return *this; }
+    EncLog& operator<<(const std::string& s) { if (m_handler) separator() << '"' << s << '"'; return *this; }
+    EncLog& operator<<(const bool b) { if (m_handler) separator() << (b ? "true" : "false"); return *this; }
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    EncLog& operator<<(const T n) { if (m_handler) separator() << +n; return *this; }
+private:
+    std::ostringstream& separator() { if (m_stream.tellp() > 0) m_stream << ' '; return m_stream; }
+    const EncLogLevel m_level;
+    const EncLogHandler m_handler;
+    std::ostringstream m_stream;
+};
+
+} // namespace
+
+static EncLog encDebug() { return EncLog(EncLogLevel::DEBUG); }
+static EncLog encWarning() { return EncLog(EncLogLevel::WARNING); }
+
+
+//---------------------------------------------------------
+// hexString - convert a 64-bit integer into a hexadecimal string
+//---------------------------------------------------------
+
+static std::string hexString(const std::int64_t nr)
+{
+    std::ostringstream res;
+    if (nr < 0)
+        res << '-' << std::hex << -static_cast<std::uint64_t>(nr);
+    else
+        res << std::hex << nr;
+    return res.str();
+}
+
+
+//---------------------------------------------------------
+// appendUtf8 - append code point cp to text encoded as UTF-8
 //---------------------------------------------------------
 
-static QString hexString(const qint64 nr)
+static void appendUtf8(std::string& text, const char32_t cp)
 {
-    return QString("%1").arg(nr, 0, 16);
+    if (cp < 0x80) {
+        text += static_cast<char>(cp);
+    }
+    else if (cp < 0x800) {
+        text += static_cast<char>(0xC0 | (cp >> 6));
+        text += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        text += static_cast<char>(0xE0 | (cp >> 12));
+        text += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else {
+        text += static_cast<char>(0xF0 | (cp >> 18));
+        text += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        text += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (cp & 0x3F));
+    }
 }
 
 
+//---------------------------------------------------------
+// Utf16Decoder - convert UTF-16 code units read one at a time
+// into UTF-8, combining surrogate pairs
+// unpaired surrogates are replaced by U+FFFD (as QString does)
+// finish() must be called after the last code unit
+//---------------------------------------------------------
+
+namespace {
+
+class Utf16Decoder
+{
+public:
+    explicit Utf16Decoder(std::string& text) : m_text(text) {}
+    void append(const char16_t u)
+    {
+        if (u >= 0xD800 && u < 0xDC00) {
+            if (m_high) appendUtf8(m_text, 0xFFFD);
+            m_high = u;
+            return;
+        }
+        if (u >= 0xDC00 && u < 0xE000) {
+            if (m_high)
+                appendUtf8(m_text, 0x10000 + ((char32_t(m_high) - 0xD800) << 10) + (u - 0xDC00));
+            else
+                appendUtf8(m_text, 0xFFFD);
+            m_high = 0;
+            return;
+        }
+        if (m_high) appendUtf8(m_text, 0xFFFD);
+        m_high = 0;
+        appendUtf8(m_text, u);
+    }
+    void finish()
+    {
+        if (m_high) appendUtf8(m_text, 0xFFFD);
+        m_high = 0;
+    }
+private:
+    std::string& m_text;
+    char16_t m_high { 0 };
+};
+
+} // namespace
+
+
 //---------------------------------------------------------
 // readMagic - read four bytes from data into magic
 //---------------------------------------------------------
 
-static bool readMagic(QDataStream& data, QString& magic)
+static bool readMagic(EncStream& data, std::string& magic)
 {
     for (int i = 0; i < 4 && !data.atEnd(); ++i) {
         quint8 ch;
         data >> ch;
-        magic.append(QChar(ch));
+        magic += static_cast<char>(ch);
     }
-    qDebug()
-        << "filepos" << hexString(data.device()->pos() - 4)
+    encDebug()
+        << "filepos" << hexString(data.pos() - 4)
         << "magic" << magic;
     return true;
 }
 
 
+//---------------------------------------------------------
+// isDigit - check if ch is an ASCII digit
+//---------------------------------------------------------
+
+static bool isDigit(const char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+
 //---------------------------------------------------------
 // isEncInstrumentMagic - check if magic equals "TK<number><number>"
 // (typically TK00) corresponding to an instrument block
 //---------------------------------------------------------
 
-static bool isEncInstrumentMagic(const QString& magic)
+static bool isEncInstrumentMagic(const std::string& magic)
 {
     if (magic.length() < 4)
         return false;
 
-    if (magic.at(0) == 'T' && magic.at(1) == 'K' && magic.at(2).isDigit() && magic.at(3).isDigit())
+    if (magic.at(0) == 'T' && magic.at(1) == 'K' && isDigit(magic.at(2)) && isDigit(magic.at(3)))
         return true;
 
     return false;
@@ -81,7 +217,7 @@ static bool isEncInstrumentMagic(const QString& magic)
 // we know how to handle
 //---------------------------------------------------------
 
-static bool isKnownMagic(const QString& magic)
+static bool isKnownMagic(const std::string& magic)
 {
     if (magic.length() < 4)
         return false;
@@ -96,28 +232,28 @@ static bool isKnownMagic(const QString& magic)
 // we know how to handle
 //---------------------------------------------------------
 
-static QString findNextKnownMagic(QDataStream& data)
+static std::string findNextKnownMagic(EncStream& data)
 {
-    QString magic;
+    std::string magic;
 
     for (int i = 0; i < 4 && !data.atEnd(); ++i) {
         quint8 ch;
         data >> ch;
-        magic.append(QChar(ch));
+        magic += static_cast<char>(ch);
     }
 
     while (!isKnownMagic(magic) && !data.atEnd()) {
-        magic.remove(0, 1);
+        magic.erase(0, 1);
         quint8 ch;
         data >> ch;
-        magic.append(QChar(ch));
+        magic += static_cast<char>(ch);
     }
 
     if (!isKnownMagic(magic))
         magic = "";
 
-    qDebug()
-        << "filepos" << hexString(data.device()->pos() - 4)
+    encDebug()
+        << "filepos" << hexString(data.pos() - 4)
         << "magic" << magic;
 
     return magic;
@@ -133,18 +269,18 @@ EncHeader::EncHeader()
 }
 
 
-bool EncHeader::read(QDataStream& data)
+bool EncHeader::read(EncStream& data)
 {
     readMagic(data, m_magic);
-    qDebug() << "m_magic" << m_magic;
+    encDebug() << "m_magic" << m_magic;
     if (m_magic == "SCOW") {
-        data.setByteOrder(QDataStream::LittleEndian);
+        data.setByteOrder(EncStream::LittleEndian);
     }
     else if (m_magic == "SCO5") {
-        data.setByteOrder(QDataStream::BigEndian);
+        data.setByteOrder(EncStream::BigEndian);
     }
     else {
-        qDebug() << "m_magic" << m_magic << "is incorrect";
+        encDebug() << "m_magic" << m_magic << "is incorrect";
         m_magic = "";
         return false;
     }
@@ -163,9 +299,9 @@ bool EncHeader::read(QDataStream& data)
 }
 
 
-QDebug operator<<(QDebug dbg, const EncHeader& header)
+static EncLog& operator<<(EncLog& log, const EncHeader& header)
 {
-    dbg
+    log
         << "m_magic" << header.m_magic
         << "m_chuMagio" << header.m_chuMagio
         << "m_chuVersio" << header.m_chuVersio
@@ -177,7 +313,7 @@ QDebug operator<<(QDebug dbg, const EncHeader& header)
         << "m_staffPerSystem" << header.m_staffPerSystem
         << "m_measureCount" << header.m_measureCount
         ;
-    return dbg;
+    return log;
 }
 
 //---------------------------------------------------------
@@ -190,9 +326,9 @@ EncInstrument::EncInstrument()
 }
 
 
-bool EncInstrument::read(QDataStream& data, const quint32 var_size, bool probeEncoding)
+bool EncInstrument::read(EncStream& data, const quint32 var_size, bool probeEncoding)
 {
-    qDebug() << "EncInstrument::read()";
+    encDebug() << "EncInstrument::read()";
     m_offset = var_size;
     m_offset &= 0xFFFF; // TODO: ritmo.enc fails when m_offset is assumed to be 32 bit
 
@@ -202,27 +338,28 @@ bool EncInstrument::read(QDataStream& data, const quint32 var_size, bool probeEn
     // the name is UTF-16 LE.
     CharSize cs = charSize();
     if (probeEncoding && cs == CharSize::ONE_BYTE) {
-        const qint64 savedPos = data.device()->pos();
+        const std::int64_t savedPos = data.pos();
         quint8 b0 = 0, b1 = 0;
         data >> b0 >> b1;
-        data.device()->seek(savedPos);
+        data.seek(savedPos);
         if (b0 >= 0x20 && b0 < 0x7F && b1 == 0x00)
             cs = CharSize::TWO_BYTES;
     }
 
-    qDebug()
+    encDebug()
         << "m_offset" << m_offset
         << "charSize" << static_cast<int>(cs)
         ;
 
     int nread = 8; // # bytes read so far
-    QChar ch;
+    char16_t ch;
     bool ready = false;
+    Utf16Decoder name(m_name);
     while (!ready) {
         if (cs == CharSize::ONE_BYTE) {
             quint8 b;
             data >> b;
-            ch = QChar(char16_t(b));
+            ch = char16_t(b);
             nread += 1;
         }
         else if (cs == CharSize::TWO_BYTES) {
@@ -230,15 +367,17 @@ bool EncInstrument::read(QDataStream& data, const quint32 var_size, bool probeEn
             nread += 2;
         }
         else {
-            qFatal("unknown CharSize");
+            encWarning() << "unknown CharSize";
+            return false;
         }
-        if (ch == '\0') {
+        if (ch == u'\0') {
             ready = true;
         }
         else
-            m_name.append(ch);
+            name.append(ch);
     }
-    qDebug() << "m_name" << m_name;
+    name.finish();
+    encDebug() << "m_name" << m_name;
     data.skipRawData(m_offset - nread);
     return true;
 }
@@ -252,13 +391,6 @@ CharSize EncInstrument::charSize() const
 }
 
 
-QDebug operator<<(QDebug dbg, const EncInstrument& /* instrument */)
-{
-    // TODO
-
-    return dbg;
-}
-
 //---------------------------------------------------------
 // EncPage
 //---------------------------------------------------------
@@ -269,12 +401,12 @@ EncPage::EncPage()
 }
 
 
-bool EncPage::read(QDataStream& data)
+bool EncPage::read(EncStream& data)
 {
-    qDebug() << "EncPage::read()";
+    encDebug() << "EncPage::read()";
     readMagic(data, m_id);
     data >> m_offset;
-    qDebug()
+    encDebug()
         << "m_id" << m_id
         << "m_offset" << m_offset
         ;
@@ -293,7 +425,7 @@ EncLineStaffData::EncLineStaffData()
 
 // note: EncLineStaffData::read() reads 30 bytes
 
-bool EncLineStaffData::read(QDataStream& data)
+bool EncLineStaffData::read(EncStream& data)
 {
     data.skipRawData(14);
     qint8 ct;
@@ -314,7 +446,7 @@ bool EncLineStaffData::read(QDataStream& data)
     m_staffType = static_cast<staffType>(st);
     data >> m_instrStaffIdx;
     data.skipRawData(8);      // skip to end
-    qDebug()
+    encDebug()
         << "m_clef" << static_cast<int>(m_clef)
         << "m_key" << m_key
         << "m_pageIdx" << m_pageIdx
@@ -337,14 +469,14 @@ EncLine::EncLine()
 // equals line's m_offset plus 8
 // observed m_offset values (decimal): 56, 86, 240, 662
 
-bool EncLine::read(QDataStream& data, const quint32 var_size, const int staffPerSystem)
+bool EncLine::read(EncStream& data, const quint32 var_size, const int staffPerSystem)
 {
-    qDebug() << "EncLine::read()";
+    encDebug() << "EncLine::read()";
     m_offset = var_size;
     data.skipRawData(10);
     data >> m_start;
     data >> m_measureCount; // 21 bytes read so far
-    qDebug()
+    encDebug()
         << "m_id" << m_id
         << "m_offset" << m_offset
         << "staffPerSystem" << staffPerSystem
@@ -357,7 +489,7 @@ bool EncLine::read(QDataStream& data, const quint32 var_size, const int staffPer
         m_lineStaffData.push_back(lineStaffData);
     }
     const int toSkip = m_offset + 8 - 21 - 30 * staffPerSystem;
-    qDebug() << "toSkip" << toSkip;
+    encDebug() << "toSkip" << toSkip;
     data.skipRawData(toSkip);     // skip to end
     return true;
 }
@@ -366,14 +498,14 @@ bool EncLine::read(QDataStream& data, const quint32 var_size, const int staffPer
 // EncMeasure
 //---------------------------------------------------------
 
-bool EncMeasure::read(QDataStream& data, const quint32 var_size, bool oldFormat, bool veryOldFormat)
+bool EncMeasure::read(EncStream& data, const quint32 var_size, bool oldFormat, bool veryOldFormat)
 {
     m_varsize = var_size;
 
     // Save start position for absolute positioning (like enc2ly does)
     // Note: enc2ly's offsets include the 4-byte size field we already read
     // So we subtract 4 from enc2ly offsets, or equivalently use (measStart - 4 + enc2ly_offset)
-    qint64 measStart = data.device()->pos();
+    std::int64_t measStart = data.pos();
 
     // Read header using absolute offsets (based on enc2ly, adjusted by -4)
     data >> m_bpm;
@@ -383,12 +515,12 @@ bool EncMeasure::read(QDataStream& data, const quint32 var_size, bool oldFormat,
     data >> m_durTicks;
 
     // enc2ly offset 0x0C -> measStart + 0x0C - 4 = measStart + 0x08
-    data.device()->seek(measStart + 0x08);
+    data.seek(measStart + 0x08);
     data >> m_timeSigNum;
     data >> m_timeSigDen;
 
     // enc2ly offset 0x10 -> measStart + 0x0C
-    data.device()->seek(measStart + 0x0C);
+    data.seek(measStart + 0x0C);
     data >> m_barTypeStart;
     data >> m_barTypeEnd;
     data.skipRawData(1);
@@ -398,10 +530,10 @@ bool EncMeasure::read(QDataStream& data, const quint32 var_size, bool oldFormat,
     // enc2ly addresses the sign byte at offset 0x1E (= measStart+0x1A), but
     // we read the full quint32 starting one byte earlier so that
     // repeat() = (m_coda >> 8) & 0xFF extracts it correctly.
-    data.device()->seek(measStart + 0x19);
+    data.seek(measStart + 0x19);
     data >> m_coda;
 
-    qDebug()
+    encDebug()
         << "m_id" << m_id
         << "m_varsize" << m_varsize
         << "m_bpm" << m_bpm
@@ -420,19 +552,19 @@ bool EncMeasure::read(QDataStream& data, const quint32 var_size, bool oldFormat,
     // Elements start at different offsets depending on format version:
     // - v0xA6 (very old): offset 0x3E, element spacing = size * 2
     // - v0xC2/v0xC4: offset 0x36, element spacing = size
-    qint64 elemOffset = veryOldFormat ? 0x3E : 0x36;
-    data.device()->seek(measStart + elemOffset);
+    std::int64_t elemOffset = veryOldFormat ? 0x3E : 0x36;
+    data.seek(measStart + elemOffset);
 
     // Calculate end of measure block for bounds checking
-    qint64 measEnd = measStart + m_varsize + elemOffset;
+    std::int64_t measEnd = measStart + m_varsize + elemOffset;
 
     quint16 tick;
     data >> tick;
-    qDebug() << "tick" << tick;
+    encDebug() << "tick" << tick;
 
     if (tick == 0xFFFF) {
         // Measure has no elements, skip to end
-        data.device()->seek(measEnd);
+        data.seek(measEnd);
         return true;
     }
 
@@ -443,29 +575,29 @@ bool EncMeasure::read(QDataStream& data, const quint32 var_size, bool oldFormat,
     while (tick != 0xFFFF) {
         // Safety check: prevent infinite loops
         if (++elemCount > MAX_ELEMENTS) {
-            qDebug() << "Too many elements, stopping to prevent infinite loop";
+            encDebug() << "Too many elements, stopping to prevent infinite loop";
             break;
         }
 
         // Safety check: don't read past measure bounds
-        if (data.device()->pos() >= measEnd - 2) {
-            qDebug() << "Reached end of measure block at pos" << data.device()->pos();
+        if (data.pos() >= measEnd - 2) {
+            encDebug() << "Reached end of measure block at pos" << data.pos();
             break;
         }
 
         // Save position where element starts (right before tick)
-        qint64 elemStart = data.device()->pos() - 2;  // -2 because we already read tick
+        std::int64_t elemStart = data.pos() - 2;  // -2 because we already read tick
 
         quint8 typeVoice;
         data >> typeVoice;
-        qDebug() << "typeVoice" << typeVoice;
+        encDebug() << "typeVoice" << typeVoice;
         // sometimes the measure element size is off by two (e.g. akordo.enc)
         // in which case the end-of-elements marker 0xFFFF is not in tick
         // but in typeVoice and the next byte
         if (typeVoice == 0xFF) {
             quint8 byteToSkip;
             data >> byteToSkip;
-            qDebug() << "byteToSkip" << byteToSkip;
+            encDebug() << "byteToSkip" << byteToSkip;
             break;
         }
         const quint8 type = typeVoice >> 4;
@@ -499,21 +631,21 @@ bool EncMeasure::read(QDataStream& data, const quint32 var_size, bool oldFormat,
             // Unknown element type - skip it using size field
             quint8 elemSize;
             data >> elemSize;
-            qDebug()
-                << "filepos" << hexString(data.device()->pos() - 1)
+            encDebug()
+                << "filepos" << hexString(data.pos() - 1)
                 << "skipping unsupported elemType" << type
                 << "size" << elemSize;
             if (elemSize > 3) {
-                data.device()->seek(elemStart + elemSize);
+                data.seek(elemStart + elemSize);
             } else {
-                qDebug() << "Invalid element size, skipping to end of measure";
+                encDebug() << "Invalid element size, skipping to end of measure";
                 break;
             }
             data >> tick;
-            qDebug() << "tick" << tick;
+            encDebug() << "tick" << tick;
             continue;
         }
-        //qDebug() << "elem:" << elem;
+        //encDebug() << "elem:" << elem;
         elem->read(data);
         if (elemType(type) != elemType::NONE)
             m_measureElems.push_back(elem);
@@ -522,26 +654,26 @@ bool EncMeasure::read(QDataStream& data, const quint32 var_size, bool oldFormat,
         // Element total size is m_size bytes starting from tick
         // For very old format (v0xA6), element spacing is size * 2
         if (elem->m_size > 0) {
-            qint64 elemSpacing = veryOldFormat ? elem->m_size * 2 : elem->m_size;
-            data.device()->seek(elemStart + elemSpacing);
+            std::int64_t elemSpacing = veryOldFormat ? elem->m_size * 2 : elem->m_size;
+            data.seek(elemStart + elemSpacing);
         } else {
             // If size is 0, something is wrong - skip a few bytes to avoid infinite loop
-            qDebug() << "Element size is 0, advancing by minimum amount";
-            data.device()->seek(data.device()->pos() + 1);
+            encDebug() << "Element size is 0, advancing by minimum amount";
+            data.seek(data.pos() + 1);
         }
 
         data >> tick;
-        qDebug() << "tick" << tick;
+        encDebug() << "tick" << tick;
 
         // Very old format (v0xA6) doesn't use 0xFFFF end marker
         // Check for end of block instead
-        if (veryOldFormat && data.device()->pos() >= measEnd - 4) {
+        if (veryOldFormat && data.pos() >= measEnd - 4) {
             break;
         }
     }
 
     // Seek to end of measure block to maintain block alignment
-    data.device()->seek(measEnd);
+    data.seek(measEnd);
     return true;
 }
 
@@ -624,13 +756,13 @@ EncMeasureElem::EncMeasureElem(quint16 tick, quint8  type, quint8 voice)
 }
 
 
-bool EncMeasureElem::read(QDataStream& data)
+bool EncMeasureElem::read(EncStream& data)
 {
     data >> m_size;
     data >> m_staffIdx;
     m_staffIdx &= 0x3F;
 
-    qDebug()
+    encDebug()
         << "m_tick" << m_tick
         << "m_type" << m_type
         << "m_voice" << m_voice
@@ -652,9 +784,9 @@ EncMeasureElemNone::EncMeasureElemNone(quint16 tick, quint8  type, quint8 voice)
 }
 
 
-bool EncMeasureElemNone::read(QDataStream& data)
+bool EncMeasureElemNone::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemNone::read()";
+    encDebug() << "EncMeasureElemNone::read()";
 
     EncMeasureElem::read(data);
     int toSkip = m_size - 5;
@@ -674,9 +806,9 @@ EncMeasureElemClef::EncMeasureElemClef(quint16 tick, quint8  type, quint8 voice)
 }
 
 
-bool EncMeasureElemClef::read(QDataStream& data)
+bool EncMeasureElemClef::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemClef::read()";
+    encDebug() << "EncMeasureElemClef::read()";
 
     EncMeasureElem::read(data);
     int toSkip = m_size - 5;
@@ -696,9 +828,9 @@ EncMeasureElemKeyChange::EncMeasureElemKeyChange(quint16 tick, quint8  type, qui
 }
 
 
-bool EncMeasureElemKeyChange::read(QDataStream& data)
+bool EncMeasureElemKeyChange::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemKeyChange::read()";
+    encDebug() << "EncMeasureElemKeyChange::read()";
 
     EncMeasureElem::read(data);
     data >> m_tipo;
@@ -706,7 +838,7 @@ bool EncMeasureElemKeyChange::read(QDataStream& data)
     if (toSkip > 0) data.skipRawData(toSkip); // skip to end
     m_xoffset = 0;                    // like in enc2ly
 
-    qDebug()
+    encDebug()
         << "m_tipo" << m_tipo
         << "m_xoffset" << m_xoffset
         ;
@@ -725,9 +857,9 @@ EncMeasureElemTie::EncMeasureElemTie(quint16 tick, quint8  type, quint8 voice)
 }
 
 
-bool EncMeasureElemTie::read(QDataStream& data)
+bool EncMeasureElemTie::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemTie::read()";
+    encDebug() << "EncMeasureElemTie::read()";
 
     EncMeasureElem::read(data);  // reads size(+3) and staffIdx(+4); stream now at +5
 
@@ -747,7 +879,7 @@ bool EncMeasureElemTie::read(QDataStream& data)
     const int toSkip = m_size - 5 - read5 - 5 - 1;
     if (toSkip > 0) data.skipRawData(toSkip);   // skip to end
 
-    qDebug()
+    encDebug()
         << "m_tick" << m_tick
         << "m_xoffset" << m_xoffset
         << "m_voice" << m_voice
@@ -769,16 +901,16 @@ EncMeasureElemBeam::EncMeasureElemBeam(quint16 tick, quint8  type, quint8 voice)
 }
 
 
-bool EncMeasureElemBeam::read(QDataStream& data)
+bool EncMeasureElemBeam::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemBeam::read()";
+    encDebug() << "EncMeasureElemBeam::read()";
 
     EncMeasureElem::read(data);
     int toSkip = m_size - 5;
     if (toSkip > 0) data.skipRawData(toSkip);     // skip to end
     m_xoffset = 255;                  // faked like in enc2ly
 
-    qDebug()
+    encDebug()
         << "m_xoffset" << m_xoffset
         ;
 
@@ -796,16 +928,16 @@ EncMeasureElemOrnament::EncMeasureElemOrnament(quint16 tick, quint8  type, quint
 }
 
 
-bool EncMeasureElemOrnament::read(QDataStream& data)
+bool EncMeasureElemOrnament::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemOrnament::read()";
+    encDebug() << "EncMeasureElemOrnament::read()";
 
     EncMeasureElem::read(data);
 
     // rem tracks bytes remaining in ornament-specific area (m_size minus 5-byte element header)
-    int rem = qMax(0, m_size - 5);
+    int rem = std::max(0, m_size - 5);
     auto rd8 = [&](quint8& f) { if (rem > 0) { data >> f; --rem; } };
-    auto sk  = [&](int n)     { int t = qMin(n, rem); if (t > 0) { data.skipRawData(t); rem -= t; } };
+    auto sk  = [&](int n)     { int t = std::min(n, rem); if (t > 0) { data.skipRawData(t); rem -= t; } };
 
     rd8(m_tipo);
     sk(4);
@@ -825,7 +957,7 @@ bool EncMeasureElemOrnament::read(QDataStream& data)
     rd8(m_tind);
     if (rem > 0) data.skipRawData(rem);
 
-    qDebug()
+    encDebug()
         << "m_tipo" << m_tipo
         << "m_xoffset" << m_xoffset
         << "m_al_mezuro" << m_al_mezuro
@@ -851,9 +983,9 @@ EncMeasureElemLyric::EncMeasureElemLyric(quint16 tick, quint8  type, quint8 voic
 }
 
 
-bool EncMeasureElemLyric::read(QDataStream& data)
+bool EncMeasureElemLyric::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemLyric::read()";
+    encDebug() << "EncMeasureElemLyric::read()";
 
     EncMeasureElem::read(data);
     int toSkip = m_size - 5;
@@ -873,9 +1005,9 @@ EncMeasureElemChord::EncMeasureElemChord(quint16 tick, quint8  type, quint8 voic
 }
 
 
-bool EncMeasureElemChord::read(QDataStream& data)
+bool EncMeasureElemChord::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemChord::read()";
+    encDebug() << "EncMeasureElemChord::read()";
 
     EncMeasureElem::read(data);
     data >> m_toniko;
@@ -889,6 +1021,7 @@ bool EncMeasureElemChord::read(QDataStream& data)
     if (hasText) {
         // read chord text, TODO: support UTF-8
         bool done = false;
+        Utf16Decoder teksto(m_teksto);
 
         for (int j = 0; j < 2 * 18 /* AKORDO_BAJTARO */;) {
             quint8 lower;
@@ -897,12 +1030,13 @@ bool EncMeasureElemChord::read(QDataStream& data)
             quint8 upper;
             data >> upper;
             ++j;
-            QChar ch = QChar(char16_t((upper << 8) + lower));
-            if (ch == '\0')
+            const char16_t ch = char16_t((upper << 8) + lower);
+            if (ch == u'\0')
                 done = true;
             if (!done)
-                m_teksto.append(ch);
+                teksto.append(ch);
         }
+        teksto.finish();
         int toSkip = m_size - 5 - 9 - 2 * 18;
         if (toSkip > 0) data.skipRawData(toSkip); // skip to end
     }
@@ -911,7 +1045,7 @@ bool EncMeasureElemChord::read(QDataStream& data)
         if (toSkip > 0) data.skipRawData(toSkip); // skip to end
     }
 
-    qDebug()
+    encDebug()
         << "m_toniko" << m_toniko
         << "m_tipo" << m_tipo
         << "m_xoffset" << m_xoffset
@@ -934,9 +1068,9 @@ EncMeasureElemNote::EncMeasureElemNote(quint16 tick, quint8  type, quint8 voice)
 }
 
 
-bool EncMeasureElemNote::read(QDataStream& data)
+bool EncMeasureElemNote::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemNote::read()";
+    encDebug() << "EncMeasureElemNote::read()";
 
     EncMeasureElem::read(data);
 
@@ -974,7 +1108,7 @@ bool EncMeasureElemNote::read(QDataStream& data)
         m_tuplet = 0;
     }
 
-    qDebug()
+    encDebug()
         << "m_faceValue" << m_faceValue
         << "m_grace1" << m_grace1
         << "m_grace2" << m_grace2
@@ -1023,9 +1157,9 @@ EncMeasureElemRest::EncMeasureElemRest(quint16 tick, quint8  type, quint8 voice)
 }
 
 
-bool EncMeasureElemRest::read(QDataStream& data)
+bool EncMeasureElemRest::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemRest::read()";
+    encDebug() << "EncMeasureElemRest::read()";
 
     EncMeasureElem::read(data);
     data >> m_faceValue;
@@ -1037,7 +1171,7 @@ bool EncMeasureElemRest::read(QDataStream& data)
     int toSkip = m_size - 10 - 5;
     if (toSkip > 0) data.skipRawData(toSkip);     // skip to end
 
-    qDebug()
+    encDebug()
         << "m_faceValue" << m_faceValue
         << "m_xoffset" << m_xoffset
         << "m_tuplet" << m_tuplet
@@ -1059,9 +1193,9 @@ EncMeasureElemUnknown::EncMeasureElemUnknown(quint16 tick, quint8  type, quint8
 }
 
 
-bool EncMeasureElemUnknown::read(QDataStream& data)
+bool EncMeasureElemUnknown::read(EncStream& data)
 {
-    qDebug() << "EncMeasureElemUnknown::read()";
+    encDebug() << "EncMeasureElemUnknown::read()";
 
     EncMeasureElem::read(data);
     int toSkip = m_size - 5;
@@ -1080,7 +1214,7 @@ bool EncMeasureElemUnknown::read(QDataStream& data)
 // size is the number of bytes remaining in the header plus the string
 // return text read
 
-static QString readSingleText(QDataStream& data)
+static std::string readSingleText(EncStream& data)
 {
     quint16 size;
     data >> size;
@@ -1088,7 +1222,7 @@ static QString readSingleText(QDataStream& data)
     data.skipRawData(14);
 
     // read the text
-    QString text;
+    std::string text;
     quint8 b { 0 };
     bool done { false };
 
@@ -1098,7 +1232,7 @@ static QString readSingleText(QDataStream& data)
             done = true;
         }
         if (!done) {
-            text += QChar(b);
+            appendUtf8(text, b);
         }
     }
 
@@ -1106,9 +1240,9 @@ static QString readSingleText(QDataStream& data)
 }
 
 
-bool EncText::read(QDataStream& data, const quint32 var_size)
+bool EncText::read(EncStream& data, const quint32 var_size)
 {
-    qDebug() << "EncText::read()";
+    encDebug() << "EncText::read()";
 
     m_varsize = var_size;
 
@@ -1121,9 +1255,9 @@ bool EncText::read(QDataStream& data, const quint32 var_size)
         m_texts.push_back(readSingleText(data));
     }
 
-    QString texts;
+    std::string texts;
     for (const auto& s : m_texts) {
-        if (!texts.isEmpty()) {
+        if (!texts.empty()) {
             texts += " ";
         }
         texts += "'";
@@ -1131,7 +1265,7 @@ bool EncText::read(QDataStream& data, const quint32 var_size)
         texts += "'";
     }
 
-    qDebug()
+    encDebug()
         << "ntexts" << ntexts
         << "m_texts" << texts
         ;
@@ -1147,13 +1281,13 @@ bool EncText::read(QDataStream& data, const quint32 var_size)
 
 // read a single text item in a TEXT block
 
-static QString readTextItem(QDataStream& data, const CharSize charsize)
+static std::string readTextItem(EncStream& data, const CharSize charsize)
 {
     // skip the item header
     data.skipRawData(30);
 
     // now at the start of the next text item, read it
-    QString item;
+    std::string item;
     bool done = false;
 
     if (charsize == CharSize::ONE_BYTE) {
@@ -1161,14 +1295,14 @@ static QString readTextItem(QDataStream& data, const CharSize charsize)
             quint8 lower;
             data >> lower;
             ++j;
-            QChar ch = QChar(char16_t(lower));
-            if (ch == '\0')
+            if (lower == 0)
                 done = true;
             if (!done)
-                item.append(ch);
+                appendUtf8(item, lower);
         }
     }
     else if (charsize == CharSize::TWO_BYTES) {
+        Utf16Decoder decoder(item);
         for (int j = 0; j < 1026;) {
             quint8 lower;
             data >> lower;
@@ -1176,22 +1310,23 @@ static QString readTextItem(QDataStream& data, const CharSize charsize)
             quint8 upper;
             data >> upper;
             ++j;
-            QChar ch = QChar(char16_t((upper << 8) + lower));
-            if (ch == '\0')
+            const char16_t ch = char16_t((upper << 8) + lower);
+            if (ch == u'\0')
                 done = true;
             if (!done)
-                item.append(ch);
+                decoder.append(ch);
         }
+        decoder.finish();
     }
     else {
-        qFatal("unknown CharSize");
+        encWarning() << "unknown CharSize";
     }
 
     return item;
 }
 
 
-bool EncTitle::read(QDataStream& data, const quint32 var_size, const CharSize charsize)
+bool EncTitle::read(EncStream& data, const quint32 var_size, const CharSize charsize)
 {
     m_varsize = var_size;
 
@@ -1220,7 +1355,8 @@ bool EncTitle::read(QDataStream& data, const quint32 var_size, const CharSize ch
         data.skipRawData(120);
     }
     else {
-        qFatal("unknown CharSize");
+        encWarning() << "unknown CharSize";
+        return false;
     }
 
     return true;
@@ -1234,7 +1370,7 @@ bool EncTitle::read(QDataStream& data, const quint32 var_size, const CharSize ch
 /*
 static void print_orna(const EncMeasureElemOrnament* const orna)
 {
-    qDebug()
+    encDebug()
             << "orna" << orna
             << "m_tick" << orna->m_tick
             << "m_type" << orna->m_type
@@ -1259,13 +1395,13 @@ static void addSpannerEnds(MeasureVec& mv)
 {
     MeasureElemVecVec mevv(mv.size());
 
-    //qDebug() << "addSpannerEnds 1";
+    //encDebug() << "addSpannerEnds 1";
     int i = 0;
     for (const auto& meas : mv) {
-        //qDebug() << "i" << i;
+        //encDebug() << "i" << i;
         for (const auto elem : meas.measureElems()) {
             if (const EncMeasureElemOrnament* const orna = dynamic_cast<const EncMeasureElemOrnament* const>(elem)) {
-                //qDebug() << "orna type" << static_cast<unsigned int>(orna->m_tipo);
+                //encDebug() << "orna type" << static_cast<unsigned int>(orna->m_tipo);
                 if (orna->type() == ornamentType::SLURSTART) { // ST_LIGARKO
                     EncMeasureElemOrnament* end_orna = new EncMeasureElemOrnament(0, 0, 0);
                     *end_orna = *orna;
@@ -1274,7 +1410,7 @@ static void addSpannerEnds(MeasureVec& mv)
                     //print_orna(orna);
                     //print_orna(end_orna);
                     const int endMeas = i + orna->m_al_mezuro;
-                    //qDebug() << "endMeas" << endMeas;
+                    //encDebug() << "endMeas" << endMeas;
                     if (endMeas >= 0 && static_cast<size_t>(endMeas) < mevv.size()) {
                         mevv.at(endMeas).push_back(end_orna);
                     } else {
@@ -1289,7 +1425,7 @@ static void addSpannerEnds(MeasureVec& mv)
                     //print_orna(orna);
                     //print_orna(end_orna);
                     const int endMeas = i + orna->m_al_mezuro;
-                    //qDebug() << "endMeas" << endMeas;
+                    //encDebug() << "endMeas" << endMeas;
                     if (endMeas >= 0 && static_cast<size_t>(endMeas) < mevv.size()) {
                         mevv.at(endMeas).push_back(end_orna);
                     } else {
@@ -1301,12 +1437,12 @@ static void addSpannerEnds(MeasureVec& mv)
         ++i;
     }
 
-    //qDebug() << "addSpannerEnds 2";
+    //encDebug() << "addSpannerEnds 2";
     int j = 0;
     for (const auto& mev : mevv) {
-        //qDebug() << "j" << j;
+        //encDebug() << "j" << j;
         for (const auto e : mev) {
-            //qDebug() << "e" << e;
+            //encDebug() << "e" << e;
             mv.at(j).push_back(e);
         }
         ++j;
@@ -1324,7 +1460,7 @@ static void fixupInstruments(std::vector<EncInstrument>& instruments, const int
     if (instruments.size() == 0) {
         for (int i = 0; i < count; ++i) {
             EncInstrument instrument;
-            instrument.m_name = QString("Part %1").arg(i + 1);
+            instrument.m_name = "Part " + std::to_string(i + 1);
             instruments.push_back(instrument);
         }
     }
@@ -1378,17 +1514,19 @@ EncFile::EncFile()
 }
 
 
-bool EncFile::read(QDataStream& data)
+bool EncFile::read(EncStream& data)
 {
-    m_header.read(data);
-    qDebug() << "header" << m_header;
+    if (!m_header.read(data)) {
+        return false;
+    }
+    encDebug() << "header" << m_header;
     CharSize charsize = CharSize::ONE_BYTE;
 
     while (!data.atEnd()) {
         auto next_id = findNextKnownMagic(data);
         quint32 var_size;
         data >> var_size;
-        qDebug() << "next id" << next_id << "var_size" << var_size;
+        encDebug() << "next id" << next_id << "var_size" << var_size;
         if (next_id == "LINE") {
             EncLine line;
             line.read(data, var_size, m_header.m_staffPerSystem);
@@ -1428,30 +1566,32 @@ bool EncFile::read(QDataStream& data)
         m_instruments.emplace_back();
 
     if (!m_header.isOldFormat() && !m_header.isVeryOldFormat()) {
-        static constexpr qint64 NAME_BASE = 202;   // header(194) + TK header(8)
-        static constexpr qint64 NAME_STEP = 2158;
+        static constexpr std::int64_t NAME_BASE = 202;   // header(194) + TK header(8)
+        static constexpr std::int64_t NAME_STEP = 2158;
         for (int n = 0; n < static_cast<int>(m_instruments.size()); ++n) {
-            if (!m_instruments.at(n).m_name.isEmpty())
+            if (!m_instruments.at(n).m_name.empty())
                 continue;
-            const qint64 off = NAME_BASE + static_cast<qint64>(n) * NAME_STEP;
-            if (off + 2 >= data.device()->size())
+            const std::int64_t off = NAME_BASE + static_cast<std::int64_t>(n) * NAME_STEP;
+            if (off + 2 >= data.size())
                 break;
-            if (!data.device()->seek(off))
+            if (!data.seek(off))
                 break;
             quint8 b0 = 0, b1 = 0;
             data >> b0 >> b1;
             if (b0 < 0x20 || b0 >= 0x7F || b1 != 0x00)
                 continue;  // not UTF-16 LE
-            data.device()->seek(off);
-            QString recovered;
+            data.seek(off);
+            std::string recovered;
+            Utf16Decoder decoder(recovered);
             while (!data.atEnd()) {
                 quint8 lo = 0, hi = 0;
                 data >> lo >> hi;
-                const QChar ch = QChar(char16_t((static_cast<quint16>(hi) << 8) | lo));
+                const char16_t ch = char16_t((static_cast<quint16>(hi) << 8) | lo);
                 if (ch == u'\0')
                     break;
-                recovered.append(ch);
+                decoder.append(ch);
             }
+            decoder.finish();
             m_instruments[n].m_name = recovered;
         }
     }
@@ -1461,13 +1601,13 @@ bool EncFile::read(QDataStream& data)
     // entry for instrument n; all 8 bytes are identical and hold the 1-indexed
     // GM program number (0 = not configured).
     if (!m_header.isOldFormat() && !m_header.isVeryOldFormat()) {
-        static constexpr qint64 PRG_BASE = 2278;
-        static constexpr qint64 PRG_STEP = 2158;
+        static constexpr std::int64_t PRG_BASE = 2278;
+        static constexpr std::int64_t PRG_STEP = 2158;
         for (int n = 0; n < static_cast<int>(m_instruments.size()); ++n) {
-            const qint64 off = PRG_BASE + static_cast<qint64>(n) * PRG_STEP;
-            if (off >= data.device()->size())
+            const std::int64_t off = PRG_BASE + static_cast<std::int64_t>(n) * PRG_STEP;
+            if (off >= data.size())
                 break;
-            if (!data.device()->seek(off))
+            if (!data.seek(off))
                 break;
             quint8 prg = 0;
             data >> prg;
@@ -25,11 +25,43 @@
 // definition of the classes representing an Encore file
 //---------------------------------------------------------
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
-#include <QDataStream>
-
 #include "commondefs.h"
+#include "encstream.h"
+
+
+//---------------------------------------------------------
+// the parser does not depend on Qt
+// the fixed size integer types are declared identically to Qt's,
+// which makes it safe to include both this file and Qt headers
+// all text is stored as UTF-8
+//---------------------------------------------------------
+
+using qint8 = std::int8_t;
+using quint8 = std::uint8_t;
+using qint16 = std::int16_t;
+using quint16 = std::uint16_t;
+using qint32 = std::int32_t;
+using quint32 = std::uint32_t;
+
+
+//---------------------------------------------------------
+// diagnostics written by the parser
+// these are passed to the handler installed by the application,
+// by default they are discarded
+// messages below the threshold are not even formatted
+//---------------------------------------------------------
+
+enum class EncLogLevel : char {
+    DEBUG,
+    WARNING
+};
+
+using EncLogHandler = void (*)(const EncLogLevel level, const std::string& message);
+void setEncLogHandler(EncLogHandler handler, const EncLogLevel threshold = EncLogLevel::DEBUG);
 
 //---------------------------------------------------------
 // Type aliases
@@ -65,11 +97,11 @@ class EncHeader
 {
 public:
     EncHeader();
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     bool isOldFormat() const { return m_chuMagio == 0xC2; }
     bool isVeryOldFormat() const { return m_chuMagio == 0xA6; }
     // TODO private:
-    QString m_magic;                     // ENCORE_STRUKTURO::magio
+    std::string m_magic;                 // ENCORE_STRUKTURO::magio
     quint8  m_chuMagio          { 0 };   // ENCORE_STRUKTURO::chu_magio
     quint16 m_chuVersio         { 0 };   // ENCORE_STRUKTURO::chu_versio
     quint16 m_nekon1            { 0 };   // ENCORE_STRUKTURO::nekon1
@@ -81,8 +113,6 @@ public:
     qint16  m_measureCount      { 0 };   // ENCORE_STRUKTURO::nmez
 };
 
-QDebug operator<<(QDebug dbg, const EncHeader& header);
-
 
 //---------------------------------------------------------
 // an instrument (part ?) ("TK<number><number>") block (typically TK00)
@@ -92,18 +122,16 @@ class EncInstrument                     // instrumento
 {
 public:
     EncInstrument();
-    bool read(QDataStream& data, const quint32 var_size, bool probeEncoding = false);
-    QString m_id;
+    bool read(EncStream& data, const quint32 var_size, bool probeEncoding = false);
+    std::string m_id;
     quint32 m_offset            { 0 };
-    QString m_name;
+    std::string m_name;
     CharSize charSize() const;          // chu_utf8
     int  m_nstaves              { 0 };
     bool m_showStaff            { true };  // false = hidden from printed score
     int  m_midiProgram          { 0 };     // 1-indexed GM program (0 = not set)
 };
 
-QDebug operator<<(QDebug dbg, const EncInstrument& instr);
-
 
 //---------------------------------------------------------
 // a page ("PAGE") block
@@ -113,8 +141,8 @@ class EncPage
 {
 public:
     EncPage();
-    bool read(QDataStream& data);
-    QString m_id;
+    bool read(EncStream& data);
+    std::string m_id;
     quint32 m_offset            { 0 };
 };
 
@@ -155,7 +183,7 @@ class EncLineStaffData                  // Encore_Liniaro
 {
 public:
     EncLineStaffData();
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     unsigned int instrumentIndex() const { return m_instrStaffIdx & 0x3F; }
     unsigned int staffIndex() const { return m_instrStaffIdx >> 6; }
     clefType  m_clef            { clefType::G };        // clef
@@ -175,9 +203,9 @@ class EncLine                           // Encore_Linio
 {
 public:
     EncLine();
-    bool read(QDataStream& data, const quint32 var_size, const int staffPerSystem);
+    bool read(EncStream& data, const quint32 var_size, const int staffPerSystem);
     const std::vector<EncLineStaffData>& lineStaffData() const { return m_lineStaffData; }
-    QString m_id;
+    std::string m_id;
     quint32 m_offset            { 0 };
     quint16 m_start             { 0 };
     quint8  m_measureCount      { 0 };  // nmez
@@ -214,7 +242,7 @@ class EncMeasureElem
 {
 public:
     EncMeasureElem(quint16 tick, quint8  type, quint8 voice);
-    virtual bool read(QDataStream& data);
+    virtual bool read(EncStream& data);
     quint16 m_tick;
     quint8  m_type;
     quint8  m_voice;
@@ -233,7 +261,7 @@ class EncMeasureElemNone : public EncMeasureElem
 {
 public:
     EncMeasureElemNone(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
 };
 
 
@@ -241,7 +269,7 @@ class EncMeasureElemClef : public EncMeasureElem
 {
 public:
     EncMeasureElemClef(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
 };
 
 
@@ -249,7 +277,7 @@ class EncMeasureElemKeyChange : public EncMeasureElem
 {
 public:
     EncMeasureElemKeyChange(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     quint8  m_tipo              { 0 };  // offset  5 ??
 };
 
@@ -258,7 +286,7 @@ class EncMeasureElemTie : public EncMeasureElem
 {
 public:
     EncMeasureElemTie(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     bool m_isTieStart { false };  // true when direction byte == 0xfe (outgoing tie)
 };
 
@@ -267,7 +295,7 @@ class EncMeasureElemBeam : public EncMeasureElem
 {
 public:
     EncMeasureElemBeam(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
 };
 
 
@@ -286,7 +314,7 @@ class EncMeasureElemOrnament : public EncMeasureElem
 {
 public:
     EncMeasureElemOrnament(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     ornamentType type() const { return static_cast<ornamentType>(m_tipo); }
     void setType(const ornamentType type) { m_tipo = static_cast<quint8>(type); }
     // check:
@@ -305,7 +333,7 @@ class EncMeasureElemLyric : public EncMeasureElem
 {
 public:
     EncMeasureElemLyric(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
 };
 
 
@@ -320,7 +348,7 @@ class EncMeasureElemNote : public EncMeasureElem
 {
 public:
     EncMeasureElemNote(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     int actualNotes() const { return m_tuplet >> 4; }
     articulationType articulationUp() const { return static_cast<articulationType>(m_articulationUp); }
     articulationType articulationDown() const { return static_cast<articulationType>(m_articulationDown); }
@@ -347,12 +375,12 @@ class EncMeasureElemChord : public EncMeasureElem
 {
 public:
     EncMeasureElemChord(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     quint8  m_toniko            { 0 };  // offset  5
     quint8  m_tipo              { 0 };  // offset  6
     quint8  m_radiko            { 0 };  // offset 12
     quint8  m_baso              { 0 };  // offset 13
-    QString m_teksto;
+    std::string m_teksto;
 };
 
 
@@ -360,7 +388,7 @@ class EncMeasureElemRest : public EncMeasureElem
 {
 public:
     EncMeasureElemRest(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     int actualNotes() const { return m_tuplet >> 4; }
     int normalNotes() const { return m_tuplet & 0x0F; }
     quint8  m_faceValue         { 0 };  // offset  5 (WithDuration) atr.pauzo.rapido
@@ -373,7 +401,7 @@ class EncMeasureElemUnknown : public EncMeasureElem
 {
 public:
     EncMeasureElemUnknown(quint16 tick, quint8  type, quint8 voice);
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
 };
 
 
@@ -411,14 +439,14 @@ class EncMeasure                        // ENCORE_MEZURO
 {
 public:
     EncMeasure() = default;
-    bool read(QDataStream& data, const quint32 var_size, bool oldFormat = false, bool veryOldFormat = false);
+    bool read(EncStream& data, const quint32 var_size, bool oldFormat = false, bool veryOldFormat = false);
     void calculateRealDurations();       // Calculate real durations from ticks
     const MeasureElemVec& measureElems() const { return m_measureElems; }
     void push_back(EncMeasureElem* elem) { m_measureElems.push_back(elem); }
     barlineType barTypeStart() const { return static_cast<barlineType>(m_barTypeStart); }
     barlineType barTypeEnd() const { return static_cast<barlineType>(m_barTypeEnd); }
     repeatType repeat() const { return static_cast<repeatType>((m_coda >> 8) & 0xFF); }
-    QString m_id;
+    std::string m_id;
     qint32  m_varsize           { 0 };
     quint16 m_bpm               { 0 };
     quint8  m_timeSigGlyph      { 0 };
@@ -444,9 +472,9 @@ class EncText
 {
 public:
     EncText() = default;
-    bool read(QDataStream& data, const quint32 var_size);
+    bool read(EncStream& data, const quint32 var_size);
     quint32  m_varsize          { 0 };
-    std::vector<QString> m_texts;
+    std::vector<std::string> m_texts;
 };
 
 
@@ -458,15 +486,15 @@ class EncTitle
 {
 public:
     EncTitle() = default;
-    bool read(QDataStream& data, const quint32 var_size, const CharSize charsize);
+    bool read(EncStream& data, const quint32 var_size, const CharSize charsize);
     quint32  m_varsize          { 0 };
-    QString m_title;
-    std::vector<QString> m_subtitle;
-    std::vector<QString> m_instruction;
-    std::vector<QString> m_author;
-    std::vector<QString> m_header;
-    std::vector<QString> m_footer;
-    std::vector<QString> m_copyright;
+    std::string m_title;
+    std::vector<std::string> m_subtitle;
+    std::vector<std::string> m_instruction;
+    std::vector<std::string> m_author;
+    std::vector<std::string> m_header;
+    std::vector<std::string> m_footer;
+    std::vector<std::string> m_copyright;
 };
 
 
@@ -478,7 +506,7 @@ class EncFile
 {
 public:
     EncFile();
-    bool read(QDataStream& data);
+    bool read(EncStream& data);
     const EncHeader& header() const { return m_header; }
     const std::vector<EncInstrument>& staves() const { return m_instruments; }
     const std::vector<EncLine>& lines() const { return m_lines; }
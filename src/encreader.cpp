@@ -0,0 +1,130 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <QFile>
+#include <QtDebug>
+
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "encfile.h"
+#include "encreader.h"
+
+
+//---------------------------------------------------------
+// forwardEncLog - pass a message from the parser to Qt's logging
+//---------------------------------------------------------
+
+static void forwardEncLog(const EncLogLevel level, const std::string& message)
+{
+    if (level == EncLogLevel::WARNING)
+        qWarning().noquote() << toQString(message);
+    else
+        qDebug().noquote() << toQString(message);
+}
+
+
+//---------------------------------------------------------
+// readEncData - read an Encore file already loaded in memory into ef
+//---------------------------------------------------------
+
+QString readEncData(const QByteArray& fileData, EncFile& ef)
+{
+    // when debug output is compiled out, don't let the parser format it
+#if defined(QT_NO_DEBUG_OUTPUT)
+    setEncLogHandler(forwardEncLog, EncLogLevel::WARNING);
+#else
+    setEncLogHandler(forwardEncLog);
+#endif
+
+    // Detectar formato ZBOT (cifrado) - magic "ZBOT" = 0x5A424F54
+    if (fileData.size() >= 4 && fileData.startsWith("ZBOT")) {
+        qWarning() << "ERROR: ZBOT format detected.";
+        qWarning() << "ZBOT files are encrypted and cannot be converted directly.";
+        qWarning() << "Please convert the file to SCOW format using Encore 5.x:";
+        qWarning() << "  1. Open the .enc file in Encore 5.x on Windows";
+        qWarning() << "  2. Save it (the new version will be in SCOW format)";
+        qWarning() << "  3. Use Enc2MusicXML with the converted file";
+        return "ERROR: ZBOT format detected.";
+    }
+
+    EncStream data(fileData.constData(), static_cast<std::size_t>(fileData.size()));
+    if (ef.read(data)) {
+        // TODO: could EncFile return more detailed errors ?
+        return "";
+    }
+    else {
+        return "error reading Encore file";
+    }
+}
+
+
+//---------------------------------------------------------
+// loadEncFile - read the raw contents of an Encore file
+//---------------------------------------------------------
+
+QString loadEncFile(const QString& filename, QByteArray& fileData)
+{
+    qDebug() << "processing file" << filename;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return "cannot open Encore file";
+    }
+    fileData = file.readAll();
+    file.close();
+    return "";
+}
+
+
+//---------------------------------------------------------
+// readEncFile - read an Encore file into ef
+//---------------------------------------------------------
+
+QString readEncFile(const QString& filename, EncFile& ef)
+{
+    QByteArray fileData;
+    const QString error = loadEncFile(filename, fileData);
+    if (!error.isEmpty()) {
+        return error;
+    }
+
+    return readEncData(fileData, ef);
+}
+
+
+//---------------------------------------------------------
+// adviseWillNeed - start asynchronous read-ahead of filename
+// the kernel keeps the pages cached after the descriptor is closed
+//---------------------------------------------------------
+
+void adviseWillNeed(const QString& filename)
+{
+#if defined(Q_OS_LINUX)
+    const int fd = ::open(QFile::encodeName(filename).constData(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+#else
+    Q_UNUSED(filename);
+#endif
+}
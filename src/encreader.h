@@ -0,0 +1,58 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef ENCREADER_H
+#define ENCREADER_H
+
+#include <string>
+
+#include <QByteArray>
+#include <QString>
+
+class EncFile;
+
+
+//---------------------------------------------------------
+// reading Encore files from disk or memory
+// this is the Qt adapter for the Qt-independent EncStream input,
+// it also forwards the parser's diagnostics to qDebug() and qWarning()
+// all functions return an empty string on success
+// and an error message otherwise
+//---------------------------------------------------------
+
+QString loadEncFile(const QString& filename, QByteArray& fileData);
+QString readEncData(const QByteArray& fileData, EncFile& ef);
+QString readEncFile(const QString& filename, EncFile& ef);
+
+
+//---------------------------------------------------------
+// convert the UTF-8 text stored in EncFile to a QString
+//---------------------------------------------------------
+
+inline QString toQString(const std::string& text) { return QString::fromStdString(text); }
+
+
+//---------------------------------------------------------
+// hint the operating system that filename will be read soon
+// (no-op on platforms without posix_fadvise)
+//---------------------------------------------------------
+
+void adviseWillNeed(const QString& filename);
+
+#endif // ENCREADER_H
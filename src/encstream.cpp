@@ -0,0 +1,51 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include "encstream.h"
+
+
+//---------------------------------------------------------
+// seek - set the read position, fails if pos is outside the data
+//---------------------------------------------------------
+
+bool EncStream::seek(const std::int64_t pos)
+{
+    if (pos < 0 || pos > m_size)
+        return false;
+    m_pos = pos;
+    return true;
+}
+
+
+//---------------------------------------------------------
+// skipRawData - skip len bytes, returns the number of bytes skipped
+// or -1 if the end was reached first
+//---------------------------------------------------------
+
+int EncStream::skipRawData(const int len)
+{
+    if (len < 0 || m_pos + len > m_size) {
+        if (len > 0)
+            m_pos = m_size;
+        m_status = ReadPastEnd;
+        return -1;
+    }
+    m_pos += len;
+    return len;
+}
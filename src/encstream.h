@@ -0,0 +1,82 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef ENCSTREAM_H
+#define ENCSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+
+//---------------------------------------------------------
+// the Encore stream reads binary data from a byte span in memory
+// it does not depend on Qt and implements the subset of QDataStream
+// needed by the parser with the same semantics: reading past the end
+// sets the status to ReadPastEnd and returns zero values
+//---------------------------------------------------------
+
+class EncStream
+{
+public:
+    enum ByteOrder { BigEndian, LittleEndian };
+    enum Status { Ok, ReadPastEnd };
+    EncStream(const char* data, const std::size_t size) : m_data(reinterpret_cast<const std::uint8_t*>(data)), m_size(static_cast<std::int64_t>(size)) {}
+    void setByteOrder(const ByteOrder bo) { m_byteOrder = bo; }
+    bool atEnd() const { return m_pos >= m_size; }
+    std::int64_t pos() const { return m_pos; }
+    std::int64_t size() const { return m_size; }
+    bool seek(const std::int64_t pos);
+    int skipRawData(const int len);
+    Status status() const { return m_status; }
+    template <typename T> EncStream& operator>>(T& value);
+private:
+    const std::uint8_t* m_data;
+    std::int64_t m_size;
+    std::int64_t m_pos { 0 };
+    ByteOrder m_byteOrder { BigEndian };
+    Status m_status { Ok };
+};
+
+
+//---------------------------------------------------------
+// operator>> - read an integer in the current byte order
+//---------------------------------------------------------
+
+template <typename T> EncStream& EncStream::operator>>(T& value)
+{
+    static_assert(std::is_integral<T>::value, "EncStream can only read integers");
+    value = 0;
+    const std::int64_t n = sizeof(T);
+    if (m_pos + n > m_size) {
+        m_pos = m_size;
+        m_status = ReadPastEnd;
+        return *this;
+    }
+    typename std::make_unsigned<T>::type res = 0;
+    for (std::int64_t i = 0; i < n; ++i) {
+        const auto b = m_data[m_pos + (m_byteOrder == BigEndian ? i : n - 1 - i)];
+        res = static_cast<decltype(res)>((res << 8) | b);
+    }
+    m_pos += n;
+    value = static_cast<T>(res);
+    return *this;
+}
+
+#endif // ENCSTREAM_H
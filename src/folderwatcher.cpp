@@ -0,0 +1,300 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <algorithm>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtDebug>
+
+#include "encfile.h"
+#include "encreader.h"
+#include "folderwatcher.h"
+#include "mxmlconverter.h"
+
+
+//---------------------------------------------------------
+// FolderWatcher - constructor
+//---------------------------------------------------------
+
+FolderWatcher::FolderWatcher(const QString& folder, const QString& outputFolder, QObject* parent)
+    : QObject(parent), m_folder(QDir(folder).absolutePath()),
+      m_outputFolder(outputFolder.isEmpty() ? QString() : QDir(outputFolder).absolutePath())
+{
+
+}
+
+
+//---------------------------------------------------------
+// ~FolderWatcher - destructor
+// wait for the running conversions, they refer to the watcher
+//---------------------------------------------------------
+
+FolderWatcher::~FolderWatcher()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+
+//---------------------------------------------------------
+// start - watch the folder and queue the files not yet converted
+//---------------------------------------------------------
+
+bool FolderWatcher::start()
+{
+    if (!QFileInfo(m_folder).isDir()) {
+        qWarning() << "cannot watch" << m_folder << "not a folder";
+        return false;
+    }
+    if (!m_outputFolder.isEmpty() && !QDir().mkpath(m_outputFolder)) {
+        qWarning() << "cannot create output folder" << m_outputFolder;
+        return false;
+    }
+    m_pool.setMaxThreadCount(std::max(1, m_jobs));
+    m_clock.start();
+    m_timer.setInterval(std::max(50, m_debounce / 2));
+    connect(&m_timer, &QTimer::timeout, this, &FolderWatcher::checkPending);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &FolderWatcher::scan);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &FolderWatcher::fileChanged);
+    if (!m_watcher.addPath(m_folder)) {
+        qWarning() << "cannot watch" << m_folder;
+        return false;
+    }
+    qInfo() << "watching" << m_folder << "jobs" << m_jobs << "debounce (ms)" << m_debounce;
+    scan();
+    return true;
+}
+
+
+//---------------------------------------------------------
+// scan - note the Encore files in the folder that are not up to date
+// called at start and when files are added, removed or renamed
+//---------------------------------------------------------
+
+void FolderWatcher::scan()
+{
+    for (auto it = m_failed.begin(); it != m_failed.end();) {
+        if (QFileInfo(it->first).exists())
+            ++it;
+        else
+            it = m_failed.erase(it);
+    }
+    const QDir dir(m_folder);
+    for (const auto& name : dir.entryList(QStringList { "*.enc", "*.ENC" }, QDir::Files, QDir::Name)) {
+        const QString path = dir.filePath(name);
+        if (m_pending.count(path) == 0 && m_queued.count(path) == 0 && !hasFailed(path) && !isUpToDate(path))
+            note(path);
+    }
+}
+
+
+//---------------------------------------------------------
+// fileChanged - an Encore file was modified in place or removed
+//---------------------------------------------------------
+
+void FolderWatcher::fileChanged(const QString& path)
+{
+    if (QFileInfo(path).exists()) {
+        note(path);
+    }
+    else {
+        m_pending.erase(path);
+        unwatch(path);
+    }
+}
+
+
+//---------------------------------------------------------
+// note - path changed, restart its debounce interval
+// the file is watched individually to see it being written to
+//---------------------------------------------------------
+
+void FolderWatcher::note(const QString& path)
+{
+    const QFileInfo fi(path);
+    PendingFile& file = m_pending[path];
+    file.m_size = fi.size();
+    file.m_modified = fi.lastModified().toMSecsSinceEpoch();
+    file.m_stableSince = m_clock.elapsed();
+    if (!m_watcher.files().contains(path))
+        m_watcher.addPath(path);
+    if (!m_timer.isActive())
+        m_timer.start();
+}
+
+
+//---------------------------------------------------------
+// unwatch - stop watching path unless it is pending or queued
+// every watched file uses a system resource (e.g. an inotify watch)
+//---------------------------------------------------------
+
+void FolderWatcher::unwatch(const QString& path)
+{
+    if (m_pending.count(path) == 0 && m_queued.count(path) == 0)
+        m_watcher.removePath(path);
+}
+
+
+//---------------------------------------------------------
+// hasFailed - true if the last conversion of path failed
+// and the file did not change since
+//---------------------------------------------------------
+
+bool FolderWatcher::hasFailed(const QString& path) const
+{
+    const auto it = m_failed.find(path);
+    if (it == m_failed.end())
+        return false;
+    const QFileInfo fi(path);
+    return fi.size() == it->second.m_size && fi.lastModified().toMSecsSinceEpoch() == it->second.m_modified;
+}
+
+
+//---------------------------------------------------------
+// checkPending - queue the pending files that did not change
+// during the debounce interval
+//---------------------------------------------------------
+
+void FolderWatcher::checkPending()
+{
+    const qint64 now = m_clock.elapsed();
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        const QFileInfo fi(it->first);
+        PendingFile& file = it->second;
+        if (!fi.exists()) {
+            const QString path = it->first;
+            it = m_pending.erase(it);
+            unwatch(path);
+            continue;
+        }
+        const qint64 modified = fi.lastModified().toMSecsSinceEpoch();
+        if (fi.size() != file.m_size || modified != file.m_modified) {
+            file.m_size = fi.size();
+            file.m_modified = modified;
+            file.m_stableSince = now;
+            ++it;
+        }
+        else if (now - file.m_stableSince >= m_debounce && m_queued.count(it->first) == 0) {
+            // a file still being converted stays pending until that is finished
+            m_ready.push_back(it->first);
+            m_queued.insert(it->first);
+            it = m_pending.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    if (m_pending.empty())
+        m_timer.stop();
+    startConversions();
+}
+
+
+//---------------------------------------------------------
+// startConversions - start converting ready files while workers are free
+//---------------------------------------------------------
+
+void FolderWatcher::startConversions()
+{
+    while (m_running < m_jobs && !m_ready.empty()) {
+        const QString input = m_ready.front();
+        m_ready.pop_front();
+        const QString output = outputFileName(input);
+        ++m_running;
+        m_pool.start([this, input, output]() { convert(input, output); });
+    }
+}
+
+
+//---------------------------------------------------------
+// convert - convert input to output, called in a pool thread
+// the output is replaced atomically, readers never see a partial file
+//---------------------------------------------------------
+
+void FolderWatcher::convert(const QString& input, const QString& output)
+{
+    QElapsedTimer timer;
+    timer.start();
+    EncFile ef;
+    QString error = readEncFile(input, ef);
+    if (error.isEmpty()) {
+        QSaveFile file(output);
+        if (!file.open(QIODevice::WriteOnly)) {
+            error = "cannot open MusicXML file";
+        }
+        else {
+            MxmlConverter mf(ef, &file);
+            mf.convertEncToMxml(m_timewise);
+            if (!file.commit())
+                error = "cannot write MusicXML file";
+        }
+    }
+    const qint64 elapsed = timer.elapsed();
+    QMetaObject::invokeMethod(this, [this, input, error, elapsed]() { conversionFinished(input, error, elapsed); }, Qt::QueuedConnection);
+}
+
+
+//---------------------------------------------------------
+// conversionFinished - a worker finished converting input
+//---------------------------------------------------------
+
+void FolderWatcher::conversionFinished(const QString& input, const QString& error, const qint64 elapsed)
+{
+    --m_running;
+    m_queued.erase(input);
+    if (error.isEmpty()) {
+        m_failed.erase(input);
+        qInfo() << "converted" << input << "to" << outputFileName(input) << "in" << elapsed << "ms";
+    }
+    else {
+        const QFileInfo fi(input);
+        PendingFile& file = m_failed[input];
+        file.m_size = fi.size();
+        file.m_modified = fi.lastModified().toMSecsSinceEpoch();
+        qWarning() << input << error;
+    }
+    unwatch(input);
+    startConversions();
+}
+
+
+//---------------------------------------------------------
+// outputFileName - the MusicXML file for input
+//---------------------------------------------------------
+
+QString FolderWatcher::outputFileName(const QString& input) const
+{
+    const QFileInfo fi(input);
+    const QString name = fi.completeBaseName() + ".musicxml";
+    return m_outputFolder.isEmpty() ? fi.dir().filePath(name) : QDir(m_outputFolder).filePath(name);
+}
+
+
+//---------------------------------------------------------
+// isUpToDate - true if the output of input exists and is not older
+//---------------------------------------------------------
+
+bool FolderWatcher::isUpToDate(const QString& input) const
+{
+    const QFileInfo out(outputFileName(input));
+    return out.exists() && out.lastModified().toMSecsSinceEpoch() >= QFileInfo(input).lastModified().toMSecsSinceEpoch();
+}
@@ -0,0 +1,98 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <deque>
+#include <map>
+#include <set>
+
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+
+
+//---------------------------------------------------------
+// a changed file waiting until it is completely written
+//---------------------------------------------------------
+
+struct PendingFile
+{
+    qint64  m_size              { -1 };
+    qint64  m_modified          { 0 };      // last modification, ms since the epoch
+    qint64  m_stableSince       { 0 };      // time of the last change seen, on the watcher's clock
+};
+
+
+//---------------------------------------------------------
+// the folder watcher converts the Encore files created or changed in a
+// folder to MusicXML, next to the file or in an output folder
+// a file is converted once its size and modification time did not
+// change during the debounce interval, which is taken as fully written
+// at most m_jobs files are converted at the same time, further files
+// wait in a queue holding each file at most once
+// a file is up to date if its output is not older than the file itself
+// files are watched individually only while pending or being converted,
+// other changes are seen when the folder changes
+// a file that failed to convert is skipped until its size or
+// modification time changes
+//---------------------------------------------------------
+
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    FolderWatcher(const QString& folder, const QString& outputFolder, QObject* parent = nullptr);
+    ~FolderWatcher();
+    bool start();
+    void setDebounce(const int debounce) { m_debounce = debounce; }
+    void setJobs(const int jobs) { m_jobs = jobs; }
+    void setTimewise(const bool timewise) { m_timewise = timewise; }
+private:
+    void scan();
+    void fileChanged(const QString& path);
+    void note(const QString& path);
+    void unwatch(const QString& path);
+    bool hasFailed(const QString& path) const;
+    void checkPending();
+    void startConversions();
+    void convert(const QString& input, const QString& output);
+    void conversionFinished(const QString& input, const QString& error, const qint64 elapsed);
+    QString outputFileName(const QString& input) const;
+    bool isUpToDate(const QString& input) const;
+    const QString m_folder;
+    const QString m_outputFolder;                   // empty to write next to the input
+    int m_debounce { 500 };                         // milliseconds
+    int m_jobs { 1 };
+    bool m_timewise { false };
+    QFileSystemWatcher m_watcher;
+    QTimer m_timer;                                 // runs while files are pending
+    QElapsedTimer m_clock;
+    QThreadPool m_pool;
+    std::map<QString, PendingFile> m_pending;       // changed, waiting until stable
+    std::deque<QString> m_ready;                    // stable, waiting for a worker
+    std::set<QString> m_queued;                     // in m_ready or being converted
+    std::map<QString, PendingFile> m_failed;        // size and modification time when the conversion failed
+    int m_running { 0 };
+};
+
+#endif // FOLDERWATCHER_H
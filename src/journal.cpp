@@ -0,0 +1,146 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QtDebug>
+
+#include "journal.h"
+
+
+//---------------------------------------------------------
+// open - read the entries recorded in filename and open it for appending
+// later lines override earlier ones for the same input
+//---------------------------------------------------------
+
+bool ConversionJournal::open(const QString& filename)
+{
+    m_file.setFileName(filename);
+    if (m_file.open(QIODevice::ReadOnly)) {
+        while (!m_file.atEnd()) {
+            QByteArray line = m_file.readLine();
+            if (line.endsWith('\n'))
+                line.chop(1);
+            const QList<QByteArray> fields = line.split('\t');
+            if (fields.size() != 5) {
+                continue;
+            }
+            JournalEntry entry;
+            entry.m_hash = fields.at(0);
+            entry.m_size = fields.at(1).toLongLong();
+            entry.m_modified = fields.at(2).toLongLong();
+            entry.m_converted = fields.at(3) == "ok";
+            m_entries.insert(QString::fromUtf8(QByteArray::fromPercentEncoding(fields.at(4))), entry);
+        }
+        m_file.close();
+    }
+    qDebug() << "journal" << filename << "entries" << m_entries.size();
+
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "cannot open journal" << filename << m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+
+//---------------------------------------------------------
+// isUpToDate - true if input was converted successfully before, is unchanged
+// since and all outputs still exist
+// the contents are only hashed when the size matches but the time does not
+//---------------------------------------------------------
+
+bool ConversionJournal::isUpToDate(const QString& input, const QStringList& outputs) const
+{
+    const QString path = key(input);
+    if (!m_entries.contains(path)) {
+        return false;
+    }
+    const JournalEntry entry = m_entries.value(path);
+    if (!entry.m_converted) {
+        return false;
+    }
+    for (const auto& output : outputs) {
+        if (!QFileInfo(output).exists()) {
+            return false;
+        }
+    }
+    const QFileInfo fi(input);
+    if (fi.size() != entry.m_size) {
+        return false;
+    }
+    if (fi.lastModified().toMSecsSinceEpoch() == entry.m_modified) {
+        return true;
+    }
+    return fingerprint(input).m_hash == entry.m_hash;
+}
+
+
+//---------------------------------------------------------
+// record - append the outcome of converting input
+// fingerprint is taken before the conversion started
+//---------------------------------------------------------
+
+void ConversionJournal::record(const QString& input, const JournalEntry& fingerprint, const bool converted)
+{
+    QByteArray line = fingerprint.m_hash;
+    line += '\t';
+    line += QByteArray::number(fingerprint.m_size);
+    line += '\t';
+    line += QByteArray::number(fingerprint.m_modified);
+    line += '\t';
+    line += converted ? "ok" : "failed";
+    line += '\t';
+    line += key(input).toUtf8().toPercentEncoding("/: ");
+    line += '\n';
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.write(line);
+    m_file.flush();
+}
+
+
+//---------------------------------------------------------
+// fingerprint - the size, modification time and hash of input
+//---------------------------------------------------------
+
+JournalEntry ConversionJournal::fingerprint(const QString& input)
+{
+    JournalEntry res;
+    const QFileInfo fi(input);
+    res.m_size = fi.size();
+    res.m_modified = fi.lastModified().toMSecsSinceEpoch();
+    QFile file(input);
+    if (file.open(QIODevice::ReadOnly)) {
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        hash.addData(&file);
+        res.m_hash = hash.result().toHex();
+    }
+    return res;
+}
+
+
+//---------------------------------------------------------
+// key - the journal key of input, independent of the working directory
+//---------------------------------------------------------
+
+QString ConversionJournal::key(const QString& input)
+{
+    return QFileInfo(input).absoluteFilePath();
+}
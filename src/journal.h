@@ -0,0 +1,67 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <mutex>
+
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+
+
+//---------------------------------------------------------
+// the state of an input file when it was converted
+//---------------------------------------------------------
+
+struct JournalEntry
+{
+    qint64      m_size          { -1 };
+    qint64      m_modified      { 0 };      // last modification, ms since the epoch
+    QByteArray  m_hash;                     // SHA-256 of the contents, hex encoded
+    bool        m_converted     { false };  // false if the conversion failed
+};
+
+
+//---------------------------------------------------------
+// the conversion journal records the outcome of converting each input,
+// so that a restarted batch can skip the inputs already converted
+// the journal file is append-only, one line per conversion, flushed
+// immediately: an interrupted run loses at most the file in progress
+// line format (tab separated):
+// hash size modified outcome path
+// the path is percent-encoded, so it contains no tabs or line breaks
+//---------------------------------------------------------
+
+class ConversionJournal
+{
+public:
+    bool open(const QString& filename);
+    bool isUpToDate(const QString& input, const QStringList& outputs) const;
+    void record(const QString& input, const JournalEntry& fingerprint, const bool converted);
+    static JournalEntry fingerprint(const QString& input);
+private:
+    static QString key(const QString& input);
+    QHash<QString, JournalEntry> m_entries;
+    QFile m_file;
+    std::mutex m_mutex;                     // protects m_file when recording from several threads
+};
+
+#endif // JOURNAL_H
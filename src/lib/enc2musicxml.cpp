@@ -0,0 +1,257 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <QBuffer>
+#include <QByteArray>
+
+#include "encfile.h"
+#include "encreader.h"
+#include "enc2musicxml.h"
+#include "mxmlconverter.h"
+
+
+//---------------------------------------------------------
+// the sink device passes everything written to it to a callback
+//---------------------------------------------------------
+
+class SinkDevice : public QIODevice
+{
+public:
+    SinkDevice(e2m_sink sink, void* context) : m_sink(sink), m_context(context) {}
+    bool failed() const { return m_failed; }
+    bool isSequential() const override { return true; }
+protected:
+    qint64 readData(char*, qint64) override { return -1; }
+    qint64 writeData(const char* data, qint64 len) override;
+private:
+    e2m_sink m_sink;
+    void* m_context;
+    bool m_failed { false };
+};
+
+
+//---------------------------------------------------------
+// writeData - pass data to the callback, fail permanently on error
+//---------------------------------------------------------
+
+qint64 SinkDevice::writeData(const char* data, qint64 len)
+{
+    if (m_failed)
+        return -1;
+    if (m_sink(m_context, data, static_cast<size_t>(len)) != 0) {
+        m_failed = true;
+        return -1;
+    }
+    return len;
+}
+
+
+//---------------------------------------------------------
+// the progress adapter passes the progress to a C callback
+// and cancels the conversion when the callback asks for it
+//---------------------------------------------------------
+
+class ProgressAdapter : public ConversionObserver
+{
+public:
+    ProgressAdapter(e2m_progress progress, void* context) : m_progress(progress), m_context(context) {}
+    void measureConverted(const ConversionProgress& progress) override;
+    const CancellationToken* token() const { return &m_token; }
+private:
+    e2m_progress m_progress;
+    void* m_context;
+    CancellationToken m_token;
+};
+
+
+//---------------------------------------------------------
+// measureConverted - call the callback, cancel if it returns non-zero
+//---------------------------------------------------------
+
+void ProgressAdapter::measureConverted(const ConversionProgress& progress)
+{
+    e2m_progress_info info;
+    info.part = progress.m_partNr;
+    info.partCount = progress.m_partCount;
+    info.measure = progress.m_measureNr + 1;
+    info.measureCount = progress.m_measureCount;
+    info.measuresDone = progress.m_measuresDone;
+    info.measuresTotal = progress.m_measuresTotal;
+    info.elapsedMs = progress.m_elapsed;
+    if (m_progress(m_context, &info) != 0)
+        m_token.cancel();
+}
+
+
+//---------------------------------------------------------
+// convert - parse data and convert it to MusicXML written to device
+//---------------------------------------------------------
+
+static e2m_status convert(const void* data, const size_t size, QIODevice* device,
+                          e2m_progress progress, void* progressContext)
+{
+    if (size >= 4 && std::memcmp(data, "ZBOT", 4) == 0)
+        return E2M_ERROR_ZBOT_FORMAT;
+
+    // the input is not copied, it must stay valid during the conversion
+    const QByteArray fileData = QByteArray::fromRawData(static_cast<const char*>(data), static_cast<qsizetype>(size));
+    EncFile ef;
+    if (!readEncData(fileData, ef).isEmpty())
+        return E2M_ERROR_READ;
+
+    MxmlConverter mf(ef, device);
+    ProgressAdapter adapter(progress, progressContext);
+    if (progress) {
+        mf.setObserver(&adapter);
+        mf.setCancellationToken(adapter.token());
+    }
+    return mf.convertEncToMxml() ? E2M_OK : E2M_ERROR_CANCELLED;
+}
+
+
+//---------------------------------------------------------
+// e2m_convert_to_buffer
+//---------------------------------------------------------
+
+e2m_status e2m_convert_to_buffer(const void* data, size_t size, char** output, size_t* outputSize)
+{
+    return e2m_convert_to_buffer_with_progress(data, size, output, outputSize, nullptr, nullptr);
+}
+
+
+//---------------------------------------------------------
+// e2m_convert_to_buffer_with_progress
+//---------------------------------------------------------
+
+e2m_status e2m_convert_to_buffer_with_progress(const void* data, size_t size, char** output, size_t* outputSize,
+                                               e2m_progress progress, void* progressContext)
+{
+    if (!data || size == 0 || !output || !outputSize)
+        return E2M_ERROR_INVALID_ARGUMENT;
+    *output = nullptr;
+    *outputSize = 0;
+
+    try {
+        QByteArray xml;
+        QBuffer buffer(&xml);
+        buffer.open(QIODevice::WriteOnly);
+        const e2m_status status = convert(data, size, &buffer, progress, progressContext);
+        buffer.close();
+        if (status != E2M_OK)
+            return status;
+
+        // allocate one extra byte to return a null-terminated string
+        char* const res = static_cast<char*>(std::malloc(static_cast<size_t>(xml.size()) + 1));
+        if (!res)
+            return E2M_ERROR_OUT_OF_MEMORY;
+        std::memcpy(res, xml.constData(), static_cast<size_t>(xml.size()));
+        res[xml.size()] = '\0';
+        *output = res;
+        *outputSize = static_cast<size_t>(xml.size());
+        return E2M_OK;
+    }
+    catch (const std::bad_alloc&) {
+        return E2M_ERROR_OUT_OF_MEMORY;
+    }
+    catch (...) {
+        return E2M_ERROR_INTERNAL;
+    }
+}
+
+
+//---------------------------------------------------------
+// e2m_convert_to_sink
+//---------------------------------------------------------
+
+e2m_status e2m_convert_to_sink(const void* data, size_t size, e2m_sink sink, void* context)
+{
+    return e2m_convert_to_sink_with_progress(data, size, sink, context, nullptr, nullptr);
+}
+
+
+//---------------------------------------------------------
+// e2m_convert_to_sink_with_progress
+//---------------------------------------------------------
+
+e2m_status e2m_convert_to_sink_with_progress(const void* data, size_t size, e2m_sink sink, void* context,
+                                             e2m_progress progress, void* progressContext)
+{
+    if (!data || size == 0 || !sink)
+        return E2M_ERROR_INVALID_ARGUMENT;
+
+    try {
+        SinkDevice device(sink, context);
+        device.open(QIODevice::WriteOnly);
+        const e2m_status status = convert(data, size, &device, progress, progressContext);
+        device.close();
+        if (status != E2M_OK)
+            return status;
+        return device.failed() ? E2M_ERROR_WRITE : E2M_OK;
+    }
+    catch (const std::bad_alloc&) {
+        return E2M_ERROR_OUT_OF_MEMORY;
+    }
+    catch (...) {
+        return E2M_ERROR_INTERNAL;
+    }
+}
+
+
+//---------------------------------------------------------
+// e2m_free
+//---------------------------------------------------------
+
+void e2m_free(char* buffer)
+{
+    std::free(buffer);
+}
+
+
+//---------------------------------------------------------
+// e2m_status_string
+//---------------------------------------------------------
+
+const char* e2m_status_string(e2m_status status)
+{
+    switch (status) {
+    case E2M_OK:                        return "no error";
+    case E2M_ERROR_INVALID_ARGUMENT:    return "invalid argument";
+    case E2M_ERROR_ZBOT_FORMAT:         return "ZBOT format detected";
+    case E2M_ERROR_READ:                return "error reading Encore file";
+    case E2M_ERROR_WRITE:               return "error writing MusicXML";
+    case E2M_ERROR_OUT_OF_MEMORY:       return "out of memory";
+    case E2M_ERROR_INTERNAL:            return "internal error";
+    case E2M_ERROR_CANCELLED:           return "conversion cancelled";
+    }
+    return "unknown error";
+}
+
+
+//---------------------------------------------------------
+// e2m_version
+//---------------------------------------------------------
+
+const char* e2m_version(void)
+{
+    return "0.7";
+}
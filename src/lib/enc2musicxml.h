@@ -0,0 +1,120 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef ENC2MUSICXML_H
+#define ENC2MUSICXML_H
+
+/*
+ * C interface to the Enc2MusicXML converter, for use without
+ * starting the Enc2MusicXML executable. Input is an Encore file
+ * in memory, output is MusicXML written to an allocated buffer
+ * or passed in chunks to a callback.
+ *
+ * The functions are reentrant: independent conversions may run
+ * concurrently in different threads.
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(ENC2MUSICXML_BUILD_LIBRARY)
+#    define ENC2MUSICXML_API __declspec(dllexport)
+#  else
+#    define ENC2MUSICXML_API __declspec(dllimport)
+#  endif
+#else
+#  define ENC2MUSICXML_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* result codes, new codes will only be appended */
+typedef enum {
+    E2M_OK = 0,
+    E2M_ERROR_INVALID_ARGUMENT = 1,     /* null pointer or empty input */
+    E2M_ERROR_ZBOT_FORMAT = 2,          /* encrypted Encore file, cannot be converted */
+    E2M_ERROR_READ = 3,                 /* input is not a readable Encore file */
+    E2M_ERROR_WRITE = 4,                /* the sink callback reported an error */
+    E2M_ERROR_OUT_OF_MEMORY = 5,
+    E2M_ERROR_INTERNAL = 6,
+    E2M_ERROR_CANCELLED = 7             /* the progress callback cancelled the conversion */
+} e2m_status;
+
+/*
+ * output callback: receives the next size bytes of MusicXML
+ * must return 0 on success, any other value aborts the conversion
+ */
+typedef int (*e2m_sink)(void* context, const char* data, size_t size);
+
+/* the progress of a conversion, passed to the progress callback */
+typedef struct {
+    int part;                           /* MusicXML part number (1-based) */
+    int partCount;
+    size_t measure;                     /* measure number (1-based) */
+    size_t measureCount;                /* measures per part */
+    size_t measuresDone;                /* measures written, counted over all parts */
+    size_t measuresTotal;
+    long long elapsedMs;                /* time since the conversion started */
+} e2m_progress_info;
+
+/*
+ * progress callback: called after each measure of each part written,
+ * in the thread running the conversion
+ * must return 0 to continue, any other value cancels the conversion
+ */
+typedef int (*e2m_progress)(void* context, const e2m_progress_info* info);
+
+/* convert the Encore file in data to MusicXML in a buffer allocated
+ * by the library, to be released with e2m_free() */
+ENC2MUSICXML_API e2m_status e2m_convert_to_buffer(const void* data, size_t size,
+                                                  char** output, size_t* outputSize);
+
+/* convert the Encore file in data to MusicXML passed to sink */
+ENC2MUSICXML_API e2m_status e2m_convert_to_sink(const void* data, size_t size,
+                                                e2m_sink sink, void* context);
+
+/* as e2m_convert_to_buffer(), reporting progress to the optional callback
+ * progress, returns E2M_ERROR_CANCELLED without output if it cancels */
+ENC2MUSICXML_API e2m_status e2m_convert_to_buffer_with_progress(const void* data, size_t size,
+                                                                char** output, size_t* outputSize,
+                                                                e2m_progress progress, void* progressContext);
+
+/* as e2m_convert_to_sink(), reporting progress to the optional callback
+ * progress, returns E2M_ERROR_CANCELLED if it cancels (the output passed
+ * to sink so far is incomplete) */
+ENC2MUSICXML_API e2m_status e2m_convert_to_sink_with_progress(const void* data, size_t size,
+                                                              e2m_sink sink, void* context,
+                                                              e2m_progress progress, void* progressContext);
+
+/* release a buffer returned by e2m_convert_to_buffer() */
+ENC2MUSICXML_API void e2m_free(char* buffer);
+
+/* short English description of status */
+ENC2MUSICXML_API const char* e2m_status_string(e2m_status status);
+
+/* library version, e.g. "0.7" */
+ENC2MUSICXML_API const char* e2m_version(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ENC2MUSICXML_H */
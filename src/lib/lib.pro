@@ -0,0 +1,23 @@
+QT       = core
+
+CONFIG  += c++11
+
+TARGET   = enc2musicxml
+TEMPLATE = lib
+VERSION  = 0.7
+
+# build a static library instead with: qmake CONFIG+=staticlib
+DEFINES += ENC2MUSICXML_BUILD_LIBRARY
+
+# export only the C interface (ENC2MUSICXML_API), not the converter's classes
+CONFIG  += hide_symbols
+
+# the library runs inside the host process: keep the converter's
+# debug output off the host's stderr
+DEFINES += QT_NO_DEBUG_OUTPUT
+
+include(../core.pri)
+
+SOURCES += enc2musicxml.cpp
+
+HEADERS += enc2musicxml.h
@@ -9,13 +9,16 @@ import QtQuick.Layouts
 ApplicationWindow {
     id: root
     width: 650
-    height: 270
+    height: 640
     visible: true
     color: "white"
 
     Connections {
         target: converter
-        function onResultChanged(res) { console.log("result changed: " + res) }
+        function onResultChanged(res) {
+            console.log("result changed: " + res)
+            resultText.text = "result: " + res
+        }
     }
 
     MessageDialog {
@@ -55,6 +58,25 @@ ApplicationWindow {
         }
     }
 
+    FolderDialog {
+        id: sourceFolderDialog
+        title: "Select Encore Folder"
+        onAccepted: {
+            console.log("Encore folder: " + selectedFolder.toString())
+            sourceFolderText.text = selectedFolder.toString()
+            batchConverter.setSourceFolder(selectedFolder)
+        }
+    }
+
+    FolderDialog {
+        id: destinationFolderDialog
+        title: "Select MusicXML Folder"
+        onAccepted: {
+            console.log("MusicXML folder: " + selectedFolder.toString())
+            destinationFolderText.text = selectedFolder.toString()
+        }
+    }
+
     ColumnLayout {
         id: aColumnLayout
         spacing: 0
@@ -79,16 +101,61 @@ ApplicationWindow {
         RowLayout {
             Button {
                 text: "Convert"
-                enabled: sourceText.text !== "" && destinationText.text !== ""
+                enabled: sourceText.text !== "" && destinationText.text !== "" && !converter.busy
                 onClicked: {
                     console.log("convert '" + sourceText.text + "' to '" + destinationText.text + "'")
+                    resultText.text = ""
                     converter.convert(sourceText.text, destinationText.text)
-                    console.log("result: " + converter.getResult())
-                    resultText.text = "result: " + converter.getResult()
                 }
             }
 
+            Button { text: "Cancel"; enabled: converter.busy; onClicked: converter.cancel() }
+
             Text { id: resultText; Layout.alignment: Qt.AlignLeft }
         }
+
+        RowLayout {
+            ProgressBar { id: progressBar; from: 0; to: 1; value: converter.progress }
+            Text { id: progressText; text: converter.progressText; Layout.alignment: Qt.AlignLeft }
+        }
+
+        // folder mode: convert all Encore files in a folder
+
+        RowLayout {
+            Button { text: "Select Encore folder"; enabled: !batchConverter.busy; onClicked: sourceFolderDialog.open() }
+            Text { id: sourceFolderText; Layout.alignment: Qt.AlignLeft }
+        }
+
+        RowLayout {
+            Button { text: "Select MusicXML folder"; onClicked: destinationFolderDialog.open() }
+            Text { id: destinationFolderText; Layout.alignment: Qt.AlignLeft }
+        }
+
+        RowLayout {
+            Button {
+                text: "Convert folder"
+                enabled: sourceFolderText.text !== "" && destinationFolderText.text !== "" && !batchConverter.busy
+                onClicked: {
+                    console.log("convert folder '" + sourceFolderText.text + "' to '" + destinationFolderText.text + "'")
+                    batchConverter.convert(destinationFolderText.text)
+                }
+            }
+
+            Button { text: "Cancel"; enabled: batchConverter.busy; onClicked: batchConverter.cancel() }
+
+            Text { id: summaryText; text: batchConverter.summary; Layout.alignment: Qt.AlignLeft }
+        }
+
+        ListView {
+            id: batchList
+            Layout.preferredWidth: root.width - 20
+            Layout.preferredHeight: 300
+            clip: true
+            model: batchConverter
+            delegate: Text {
+                text: name + ": " + status + (error !== "" ? " (" + error + ")" : "")
+                color: status === "failed" ? "red" : "black"
+            }
+        }
     }
 }
@@ -18,178 +18,14 @@
 /*****************************************************************************/
 
 #include <set>
-#include <tuple>
 
 #include <QFile>
 #include <QtDebug>
 
 #include "encfile.h"
+#include "encreader.h"
 #include "mxmlconverter.h"
-
-
-//---------------------------------------------------------
-// faceValue2duration - convert Encore note type to duration
-//---------------------------------------------------------
-
-/*
- * note Encore uses:
- * value 3 -> 240
- * value 4 -> 120
- */
-
-static int faceValue2duration(const quint8 faceValue)
-{
-    switch (faceValue) {
-    //case 0: return "0";
-    case 1: return  960;
-    case 2: return  480;
-    case 3: return  240;
-    case 4: return  120;
-    case 5: return   60;
-    case 6: return   30;
-    case 7: return   15;
-    case 8: return    7;
-    }
-    return 0;
-}
-
-
-//---------------------------------------------------------
-// calculateDots - calculate number of dots from duration and faceValue
-// A dotted note has duration = base * 1.5, double dotted = base * 1.75, etc.
-//---------------------------------------------------------
-
-static int calculateDots(const int realDuration, const quint8 faceValue)
-{
-    int baseDuration = faceValue2duration(faceValue & 0x0F);
-    if (baseDuration <= 0 || realDuration <= 0) {
-        return 0;
-    }
-
-    // Check for dotted durations
-    // 1 dot: base * 3/2 = base * 1.5
-    // 2 dots: base * 7/4 = base * 1.75
-    // 3 dots: base * 15/8 = base * 1.875
-
-    if (realDuration == baseDuration) {
-        return 0;
-    } else if (realDuration == (baseDuration * 3) / 2) {
-        return 1;
-    } else if (realDuration == (baseDuration * 7) / 4) {
-        return 2;
-    } else if (realDuration == (baseDuration * 15) / 8) {
-        return 3;
-    }
-
-    return 0;
-}
-
-
-//---------------------------------------------------------
-// detectTuplet - detect tuplet from duration and faceValue
-// Returns actual notes (3 for triplet), 0 if not a tuplet
-// Sets normalNotes through output parameter
-//---------------------------------------------------------
-
-static int detectTuplet(const int realDuration, const quint8 faceValue, int& normalNotes)
-{
-    int baseDuration = faceValue2duration(faceValue & 0x0F);
-    if (baseDuration <= 0 || realDuration <= 0) {
-        normalNotes = 0;
-        return 0;
-    }
-
-    // Triplet (3:2): duration = base * 2/3
-    // e.g., eighth note base=120, triplet eighth=80
-    if (realDuration == (baseDuration * 2) / 3) {
-        normalNotes = 2;
-        return 3;
-    }
-
-    // Quintuplet (5:4): duration = base * 4/5
-    if (realDuration == (baseDuration * 4) / 5) {
-        normalNotes = 4;
-        return 5;
-    }
-
-    // Sextuplet (6:4): duration = base * 4/6 = base * 2/3 (same as triplet)
-    // Already covered by triplet case
-
-    normalNotes = 0;
-    return 0;
-}
-
-
-//---------------------------------------------------------
-// faceValue2xml - convert Encore to MusicXML note type
-//---------------------------------------------------------
-
-static QString faceValue2xml(const quint8 faceValue)
-{
-    switch (faceValue) {
-    //case 0: return "0";
-    case 1: return "whole";
-    case 2: return "half";
-    case 3: return "quarter";
-    case 4: return "eighth";
-    case 5: return "16th";
-    case 6: return "32nd";
-    case 7: return "64th";
-    case 8: return "128th";
-    }
-    return "???";
-}
-
-
-//---------------------------------------------------------
-// correctNoteType - correct note type to match actual duration
-// Common Encore bug: last note in measure has wrong duration
-// because m_durTicks is incorrect. Instead of changing duration
-// (which would overflow the measure), change the note type to match.
-//---------------------------------------------------------
-
-static QString correctNoteType(const int realDuration, const quint8 faceValue)
-{
-    // Get the type that faceValue would give
-    QString originalType = faceValue2xml(faceValue & 0x0F);
-
-    if (realDuration <= 0) {
-        return originalType;
-    }
-
-    // Find what note type matches the actual duration
-    // Check common durations: whole=960, half=480, quarter=240, eighth=120, 16th=60, 32nd=30
-    QString correctType = originalType;
-
-    if (realDuration == 960) correctType = "whole";
-    else if (realDuration == 480) correctType = "half";
-    else if (realDuration == 240) correctType = "quarter";
-    else if (realDuration == 120) correctType = "eighth";
-    else if (realDuration == 60) correctType = "16th";
-    else if (realDuration == 30) correctType = "32nd";
-    else if (realDuration == 15) correctType = "64th";
-    // Also check dotted values
-    else if (realDuration == 720) correctType = "half";      // dotted half
-    else if (realDuration == 360) correctType = "quarter";   // dotted quarter
-    else if (realDuration == 180) correctType = "eighth";    // dotted eighth
-    else if (realDuration == 90) correctType = "16th";       // dotted 16th
-    else if (realDuration == 45) correctType = "32nd";       // dotted 32nd
-    // Triplet durations (3:2 ratio, so 2/3 of normal duration)
-    else if (realDuration == 640) correctType = "whole";     // whole triplet
-    else if (realDuration == 320) correctType = "half";      // half triplet
-    else if (realDuration == 160) correctType = "quarter";   // quarter triplet
-    else if (realDuration == 80) correctType = "eighth";     // eighth triplet
-    else if (realDuration == 40) correctType = "16th";       // 16th triplet
-    else if (realDuration == 20) correctType = "32nd";       // 32nd triplet (fusa)
-    else if (realDuration == 10) correctType = "64th";       // 64th triplet
-
-    if (correctType != originalType) {
-        qDebug() << "xxx_type_fix: correcting type from" << originalType
-                 << "to" << correctType << "for duration" << realDuration;
-    }
-
-    return correctType;
-}
+#include "notevalues.h"
 
 
 //---------------------------------------------------------
@@ -236,98 +72,6 @@ static bool encClef2xml(const clefType ct, QString& sign, int& line, int& octCh)
     return res;
 }
 
-//---------------------------------------------------------
-// midipitch2xml
-//---------------------------------------------------------
-
-static int alterTab[12] = { 0,   1,   0,   1,   0,  0,   1,   0,   1,   0,   1,   0 };
-static char noteTab[12] = { 'C', 'C', 'D', 'D', 'E', 'F', 'F', 'G', 'G', 'A', 'A', 'B' };
-
-// determine pitch spelling based on pitch, accidental and key
-// (too) simple algorithm: fails e.g. for two b flats with same pitch in one measure:
-// - first (with accid) will be OK
-// - second (without accid) will not
-
-static void midipitch2xml(const quint8 pitch, const accidentalType accid, const int fifths,
-                          char& step, int& alter, int& octave)
-{
-    // 60 = C 4
-    if (accid == accidentalType::FLAT) {
-        // explicit flat
-        step   = noteTab[(pitch + 1) % 12];
-        alter  = -1;
-        octave = (pitch + 1) / 12 - 1;
-    }
-    else if (alterTab[pitch % 12] && accid == accidentalType::NONE && fifths < 0) {
-        // need alter but no accid -> choose flat if fifths < 0
-        step   = noteTab[(pitch + 1) % 12];
-        alter  = -1;
-        octave = (pitch + 1) / 12 - 1;
-    }
-    else {
-        // all others none or sharp
-        step   = noteTab[pitch % 12];
-        alter  = alterTab[pitch % 12];
-        octave = pitch / 12 - 1;
-    }
-    qDebug("xxx_midipitch2xml(pitch %d, accid %d, fifths %d) step %c, alter %d, octave %d",
-           pitch, static_cast<unsigned int>(accid), fifths, step, alter, octave);
-}
-
-
-//---------------------------------------------------------
-// TupletHandler - handle tuplet state
-// Groups tuplets by their natural duration - all tuplet notes within the same
-// tuplet group belong together. The group duration depends on note value:
-// - Eighth triplet (80 ticks each): group = 240 ticks (one quarter beat)
-// - Quarter triplet (160 ticks each): group = 480 ticks (one half beat)
-// - Sixteenth triplet (40 ticks each): group = 120 ticks (one eighth beat)
-//---------------------------------------------------------
-
-TupletState TupletHandler::newNote(const quint8 actualNotes, const quint8 normalNotes, const int tick, const int duration)
-{
-    TupletState res { TupletState::NONE };
-
-    if (actualNotes <= 0 || normalNotes <= 0) {
-        // Not a tuplet note
-        if (m_inTuplet) {
-            // End previous tuplet group
-            res = TupletState::STOP;
-            m_inTuplet = false;
-            m_groupStartTick = -1;
-            m_groupDuration = 0;
-        }
-        return res;
-    }
-
-    // Calculate the total duration of this tuplet group
-    // For 3:2, three notes replace two normal notes, so group = duration * actualNotes
-    int groupDuration = duration * actualNotes;
-
-    if (!m_inTuplet) {
-        // Start a new tuplet group
-        res = TupletState::START;
-        m_inTuplet = true;
-        m_groupStartTick = tick;
-        m_groupDuration = groupDuration;
-    }
-    else {
-        // Check if this note belongs to a different tuplet group
-        // A new group starts only if we've exceeded the current group's duration
-        // Don't start new group just because note value changed (allows mixed eighths/sixteenths)
-        if (tick >= m_groupStartTick + m_groupDuration) {
-            // Close previous tuplet and start new one
-            res = TupletState::STOPSTART;
-            m_groupStartTick = tick;
-            m_groupDuration = groupDuration;
-        }
-    }
-    // else: continue in same tuplet group (no action needed)
-
-    return res;
-}
-
-
 //---------------------------------------------------------
 // nrOfVoicesInPart - count the voices in a part
 //---------------------------------------------------------
@@ -371,7 +115,21 @@ void MxmlConverter::initVoicesPerPart()
 //---------------------------------------------------------
 
 MxmlConverter::MxmlConverter(const EncFile& ef, QIODevice* device)
-    : m_device(device), m_ef(ef), m_nc(ef)
+    : m_device(device), m_ef(ef), m_nc(ef), m_timeline(ef),
+      m_voiceTimeline(ef, m_nc, m_timeline)
+{
+    initVoicesPerPart();
+}
+
+
+//---------------------------------------------------------
+// MxmlFile - MusicXML converter constructor
+// using a NoteConnector already built for ef
+//---------------------------------------------------------
+
+MxmlConverter::MxmlConverter(const EncFile& ef, NoteConnector&& nc, QIODevice* device)
+    : m_device(device), m_ef(ef), m_nc(std::move(nc)), m_timeline(ef),
+      m_voiceTimeline(ef, m_nc, m_timeline)
 {
     initVoicesPerPart();
 }
@@ -410,20 +168,35 @@ bool MxmlConverter::isHidden(const int partNr) const
 
 //---------------------------------------------------------
 // convertEncToMxml - convert Encore to MusicXML
+// returns false if the conversion was cancelled,
+// in which case the output is incomplete
 //---------------------------------------------------------
 
-void MxmlConverter::convertEncToMxml()
+bool MxmlConverter::convertEncToMxml(const bool timewise)
 {
-    qDebug() << "MxmlConverter::convertEncToMxml()";
+    qDebug() << "MxmlConverter::convertEncToMxml()" << "timewise" << timewise;
+    m_progress = ConversionProgress();
+    for (size_t i = 0; i < m_ef.staves().size(); ++i) {
+        if (!isTablature(i) && !isHidden(i))
+            ++m_progress.m_partCount;
+    }
+    m_progress.m_measureCount = m_ef.measures().size();
+    m_progress.m_measuresTotal = m_progress.m_partCount * m_progress.m_measureCount;
+    m_timer.start();
+    m_cancelled = m_token && m_token->isCancelled();
     m_writer.setDevice(m_device);
-    m_writer.writeBegin();
-    m_writer.writeElementStart("score-partwise");
+    m_writer.writeBegin(timewise);
+    m_writer.writeElementStart(timewise ? "score-timewise" : "score-partwise");
     work();
     identification();
     partList();
-    parts();
+    if (timewise)
+        measures();
+    else
+        parts();
     m_writer.writeElementEnd();
     m_writer.writeEnd();
+    return !m_cancelled;
 }
 
 
@@ -443,69 +216,6 @@ void MxmlConverter::attributes(const int partNr)
 }
 
 
-//---------------------------------------------------------
-// Determine if measure measureNr is the first measure in an alternative ending
-//---------------------------------------------------------
-
-static bool isFirstMeasureInAltEnd(const MeasureVec& measures, const size_t measureNr)
-{
-    const auto repAlt = measures.at(measureNr).m_repeatAlternative;
-    if (repAlt == 0)
-        return false;
-
-    if (measureNr == 0)
-        return true;
-
-    if (measureNr > 0 && measures.at(measureNr - 1).m_repeatAlternative != repAlt)
-        return true;
-
-    return false;
-}
-
-
-//---------------------------------------------------------
-// Determine if measure measureNr is the last measure in an alternative ending
-//---------------------------------------------------------
-
-static bool isLastMeasureInAltEnd(const MeasureVec& measures, const size_t measureNr)
-{
-    const auto repAlt = measures.at(measureNr).m_repeatAlternative;
-    if (repAlt == 0)
-        return false;
-
-    if (measureNr == measures.size() - 1)
-        return true;
-
-    if (measureNr < measures.size() - 1 && measures.at(measureNr + 1).m_repeatAlternative != repAlt)
-        return true;
-
-    return false;
-}
-
-
-//---------------------------------------------------------
-// repeatAlternative2EndingNumber - convert repeatAlternative (one bit for each pass)
-// to MusicXML ending-number (a comma-separated list// of positive integers without leading zeros)
-//---------------------------------------------------------
-
-static QString repeatAlternative2EndingNumber(const quint8 repeatAlternative)
-{
-    const int max = 4;
-    int mask = 1;
-    QString res;
-    for (int i = 1; i <= max; ++i) {
-        if (repeatAlternative & mask) {
-            if (res.isEmpty())
-                res.setNum(i);
-            else
-                res += QString(", %1").arg(i);
-        }
-        mask <<= 1;
-    }
-    return res;
-}
-
-
 //---------------------------------------------------------
 // barlineLeft - write left barline
 //---------------------------------------------------------
@@ -516,10 +226,10 @@ void MxmlConverter::barlineLeft(const int partNr, const size_t measureNr)
 
     const bool repeatStart = (m.barTypeStart() == barlineType::REPEATSTART);
     const bool barlineDblLeft = (m.barTypeStart() == barlineType::DOUBLEL);
-    const bool endingStart = isFirstMeasureInAltEnd(m_ef.measures(), measureNr) && partNr == 0;
-    const QString endingNumber = repeatAlternative2EndingNumber(m.m_repeatAlternative);
+    const auto& info = m_timeline.at(measureNr);
+    const bool endingStart = info.m_endingStart && partNr == 0;
 
-    m_writer.writeBarlineLeft(repeatStart, endingStart, barlineDblLeft, endingNumber);
+    m_writer.writeBarlineLeft(repeatStart, endingStart, barlineDblLeft, info.m_endingNumber);
 }
 
 
@@ -534,7 +244,7 @@ void MxmlConverter::barlineRight(const int partNr, const size_t measureNr)
     const bool repeatEnd = (m.barTypeEnd() == barlineType::REPEATEND);
     const bool barlineEnd = (m.barTypeEnd() == barlineType::FINAL);
     const bool barlineDbl = (m.barTypeEnd() == barlineType::DOUBLER);
-    const bool endingStop = isLastMeasureInAltEnd(m_ef.measures(), measureNr) && partNr == 0;
+    const bool endingStop = m_timeline.at(measureNr).m_endingStop && partNr == 0;
 
     m_writer.writeBarlineRight(repeatEnd, endingStop, barlineEnd, barlineDbl, m.m_repeatAlternative);
 }
@@ -573,19 +283,19 @@ void MxmlConverter::clefs(const int partNr)
 // to a single newline separated string
 //---------------------------------------------------------
 
-static QString createMultiLineString(const std::vector<QString> strVec)
+static QString createMultiLineString(const std::vector<std::string>& strVec)
 {
-    QString res;
+    std::string res;
     if (strVec.size() > 0) {
         res += strVec.at(0);
         for (size_t i = 1; i < strVec.size(); ++i) {
-            if (!strVec.at(i).isEmpty()) {
+            if (!strVec.at(i).empty()) {
                 res += "\n";
                 res += strVec.at(i);
             }
         }
     }
-    return res;
+    return toQString(res);
 }
 
 
@@ -605,25 +315,6 @@ void MxmlConverter::identification()
 }
 
 
-//---------------------------------------------------------
-// encClef2xml - convert Encore key to MusicXML fifths
-//---------------------------------------------------------
-
-int encKeyToFifths(unsigned int key)
-{
-    std::vector<int> v =
-        {
-            //   c   f  bf  ef  af  df  gf  cf  g   d   a   e   b  fs  cs
-            /**/ 0, -1, -2, -3, -4, -5, -6, -7, 1,  2,  3,  4,  5,  6,  7
-        };
-    if (key >= v.size()) {
-        qDebug() << "encKeyToFifths: key out of range:" << key;
-        return 0;
-    }
-    return v.at(key);
-}
-
-
 //---------------------------------------------------------
 // key - write the key
 // TBD (too) simple implementation: use keysig of first staff of first measure only
@@ -635,29 +326,12 @@ void MxmlConverter::key()
     if (hasMeasures && m_ef.lines().size() > 0) {
         const auto& line = m_ef.lines().at(0);
         if (line.lineStaffData().size() > 0) {
-            const auto& data = line.lineStaffData().at(0);
-            quint8 kcType = data.m_key;
-            m_currentFifths = encKeyToFifths(kcType);
-            m_writer.writeKey(m_currentFifths);
+            m_writer.writeKey(m_timeline.at(0).m_fifths);
         }
     }
 }
 
 
-//---------------------------------------------------------
-// findKeyChange - write a key change in measure m
-//---------------------------------------------------------
-
-const EncMeasureElemKeyChange* findKeyChange(const EncMeasure& m)
-{
-    for (const auto elem : m.measureElems()) {
-        if (const EncMeasureElemKeyChange* const key = dynamic_cast<const EncMeasureElemKeyChange* const>(elem))
-            return key;
-    }
-    return nullptr;
-}
-
-
 //---------------------------------------------------------
 // keyChange - write a key change
 //---------------------------------------------------------
@@ -675,140 +349,6 @@ void MxmlConverter::keyChange(const EncMeasureElemKeyChange* keyCh)
 }
 
 
-//---------------------------------------------------------
-// Determine if note is a grace note
-//---------------------------------------------------------
-
-static bool isGrace(const EncMeasureElemNote* const note)
-{
-    return note->graceType() != GraceType::NORMALNOTE;
-}
-
-
-//---------------------------------------------------------
-// calculateDuration - calculate duration from faceValue, dots, and tuplet info
-// Common logic shared by durationNote and durationRest
-//---------------------------------------------------------
-
-static int calculateDuration(const quint8 faceValue, const quint8 dotControl,
-                             const quint8 actualNotes, const quint8 normalNotes)
-{
-    int duration = faceValue2duration(faceValue & 0x0F);
-
-    // Apply dots (each dot adds half of previous value)
-    for (int i = 0; i < (dotControl & 3); ++i) {
-        duration *= 3;
-        duration /= 2;
-    }
-
-    // Apply time modification (tuplet)
-    if (actualNotes > 0 && normalNotes > 0) {
-        duration *= normalNotes;
-        duration /= actualNotes;
-    }
-
-    return duration;
-}
-
-
-//---------------------------------------------------------
-// durationNote - determine note's duration
-//---------------------------------------------------------
-
-// isStandardDuration - true iff d matches a known MusicXML note duration value.
-// Non-standard values (e.g. raw MIDI durations in live-recorded files) are excluded
-// so that face-value-based duration is used instead.
-static bool isStandardDuration(const int d)
-{
-    switch (d) {
-    // Plain note durations (whole..128th)
-    case 960: case 480: case 240: case 120: case 60: case 30: case 15: case 7:
-    // Single-dotted (base × 3/2)
-    case 720: case 360: case 180: case 90: case 45:
-    // Double-dotted (base × 7/4): 480×7/4=840, 240×7/4=420, 120×7/4=210, 60×7/4=105
-    case 840: case 420: case 210: case 105:
-    // Triple-dotted (base × 15/8): 480×15/8=900, 240×15/8=450, 120×15/8=225
-    case 900: case 450: case 225:
-    // Triplets (base × 2/3)
-    case 640: case 320: case 160: case 80: case 40: case 20:
-        return true;
-    default:
-        return false;
-    }
-}
-
-static int durationNote(const EncMeasureElemNote* const note)
-{
-    if (isGrace(note)) {
-        return 0;
-    }
-
-    // Use realDuration when it encodes a valid written duration:
-    // - a standard note length (plain, dotted, triplet), OR
-    // - a value that matches the face-value note under a recognised tuplet ratio.
-    // For live-recorded (MIDI-input) files the raw tick difference can be much
-    // larger than the written duration (e.g. 2564 in a 960-tick measure) and
-    // would overflow if used directly; those fall through to the face value.
-    if (note->m_realDuration > 0) {
-        if (isStandardDuration(note->m_realDuration))
-            return note->m_realDuration;
-        // Tuplet check: if detectTuplet recognises this as a rational tuplet of
-        // the face-value note, use realDuration (e.g. 48 = 16th × 4/5 quintuplet).
-        int dummy = 0;
-        if (detectTuplet(note->m_realDuration, note->m_faceValue, dummy) > 0)
-            return note->m_realDuration;
-    }
-
-    // Fall back to the plain face-value duration.
-    // The Encore dotControl byte is not reliably a dot count — the MuseScore
-    // importer ignores it and infers dots from realDuration instead.
-    // Applying dotControl here produces non-standard values (e.g. 135 from a
-    // 16th with dotControl=2) that make <duration> inconsistent with <type>.
-    return faceValue2duration(note->m_faceValue & 0x0F);
-}
-
-
-//---------------------------------------------------------
-// durationRest - determine rest's duration
-//---------------------------------------------------------
-
-static int durationRest(const EncMeasureElemRest* const rest)
-{
-    // Compute the rest duration using the same approach as the MuseScore Encore
-    // importer: use face value for the base duration, then detect dots from the
-    // dotControl field (which stores the sounding duration in Encore ticks).
-    //
-    // We intentionally ignore m_tuplet: in MIDI-recorded Encore files the tuplet
-    // byte for rests is often noise (e.g. 11:6), and the old calculateDuration()
-    // path with raw actualNotes/normalNotes produced non-standard values like 49
-    // that crash MuseScore's MusicXML importer.
-    const int fv   = rest->m_faceValue & 0x0F;
-    const int base = faceValue2duration(fv);
-    if (base <= 0) return 0;
-
-    // Detect dot count from dotControl (visual sounding duration).
-    // dotControl == base     → 0 dots (plain)
-    // dotControl == base*3/2 → 1 dot  (dotted)
-    // dotControl == base*7/4 → 2 dots (double-dotted)
-    int dots = 0;
-    if (rest->m_dotControl > 0) {
-        const int dc = static_cast<int>(rest->m_dotControl);
-        if      (dc == base * 3 / 2) dots = 1;
-        else if (dc == base * 7 / 4) dots = 2;
-        else if (dc == base * 15 / 8) dots = 3;
-        // Non-standard value: fall through (dots = 0, plain face value)
-    }
-
-    // Apply dots using the correct formula (not iterative *3/2 which gives 9/4 for 2 dots):
-    // 0 dots: base, 1 dot: base*3/2, 2 dots: base*7/4, 3 dots: base*15/8
-    int result = base;
-    if      (dots == 1) result = base * 3 / 2;
-    else if (dots == 2) result = base * 7 / 4;
-    else if (dots == 3) result = base * 15 / 8;
-    return result;
-}
-
-
 //---------------------------------------------------------
 // debug
 //---------------------------------------------------------
@@ -863,84 +403,28 @@ static void dump_note_timing_measure_elems(const EncMeasure& m, const QString& i
 
 
 //---------------------------------------------------------
-// encRepeatToWords - convert Encore repeats to MusicXML words
-//---------------------------------------------------------
-
-static QString encRepeatToWords(const repeatType repeat)
-{
-    QString words;
-
-    if (repeat == repeatType::DS)
-        words = "D.S.";
-    else if (repeat == repeatType::DCALCODA)
-        words = "D.C. al Coda";
-    else if (repeat == repeatType::DCALFINE)
-        words = "D.C. al Fine";
-    else if (repeat == repeatType::DSALCODA)
-        words = "D.S. al Coda";
-    else if (repeat == repeatType::DSALFINE)
-        words = "D.S. al Fine";
-    else if (repeat == repeatType::DC)
-        words = "D.C.";
-    else if (repeat == repeatType::FINE)
-        words = "Fine";
-
-    return words;
-}
-
-
-//---------------------------------------------------------
-// notesAreInChord - determine if note1 and note2 are in a chord together
+// measure - write a measure of a part
 //---------------------------------------------------------
 
-// MIDI-recorded chords have simultaneous notes at ticks 0,1,2,... due to recording
-// latency. CHORD_MIDI_THRESHOLD defines the window for grouping them as a single chord.
-static constexpr int CHORD_MIDI_THRESHOLD = 2 * CHORD_CLUSTER_THRESHOLD;  // = 8
-
-// isChordOf - true iff note2's tick is within CHORD_MIDI_THRESHOLD of rootTick.
-static bool isChordOf(const int rootTick, const EncMeasureElemNote* const note2)
+void MxmlConverter::measure(const int partNr, const size_t measureNr)
 {
-    if (!note2 || rootTick < 0) return false;
-    const int delta = (int)note2->m_tick - rootTick;
-    return delta >= 0 && delta < CHORD_MIDI_THRESHOLD;
-}
-
+    if (measureNr >= m_ef.measures().size())
+        return;
 
-// theoreticalDurTicks - the time-signature-correct measure duration in Encore ticks.
-// m_durTicks comes from the raw MIDI recording and can be off by a few ticks.
-// This computes what the measure *should* be from the written time signature.
-static int theoreticalDurTicks(const EncMeasure& m)
-{
-    if (m.m_timeSigNum == 0 || m.m_timeSigDen == 0)
-        return m.m_durTicks;
-    int beatTicks = 0;
-    switch (m.m_timeSigDen) {
-    case 1:  beatTicks = 960; break;
-    case 2:  beatTicks = 480; break;
-    case 4:  beatTicks = 240; break;
-    case 8:  beatTicks = 120; break;
-    case 16: beatTicks = 60;  break;
-    case 32: beatTicks = 30;  break;
-    case 64: beatTicks = 15;  break;
-    default: beatTicks = 240; break;
-    }
-    return m.m_timeSigNum * beatTicks;
+    m_writer.writeElementStartWithAttribute("measure", "number", measureNr + 1);
+    measureContents(partNr, measureNr);
+    m_writer.writeElementEnd();
 }
 
 
 //---------------------------------------------------------
-// measure - write a measure of a part
+// measureContents - write the contents of a measure of a part
 //---------------------------------------------------------
 
-void MxmlConverter::measure(const int partNr, const size_t measureNr)
+void MxmlConverter::measureContents(const int partNr, const size_t measureNr)
 {
-    if (measureNr >= m_ef.measures().size())
-        return;
-
-    m_writer.writeElementStartWithAttribute("measure", "number", measureNr + 1);
-
     const auto& m = m_ef.measures().at(measureNr);
-    const auto keyCh = findKeyChange(m);
+    const auto& info = m_timeline.at(measureNr);
 
 
     qDebug() << "xxx_note_timing"
@@ -948,21 +432,17 @@ void MxmlConverter::measure(const int partNr, const size_t measureNr)
         ;
     dump_note_timing_measure_elems(m, "xxx_note_timing");
 
-    std::set<quint8> voices;
-    for (const auto e : m.measureElems()) {
-        if (e->m_staffIdx == partNr)
-            voices.insert(e->m_voice);
-    }
+    const auto& voices = m_voiceTimeline.voices(measureNr, partNr);
 
     qDebug() << "xxx_voice_timing"
              << "measureNr" << measureNr
         ;
-    for (const auto v : voices) {
+    for (const auto& ve : voices) {
         qDebug() << "xxx_voice_timing"
-                 << "voice" << v
+                 << "voice" << ve.m_voice
             ;
         for (const auto& elem : m.measureElems()) {
-            if (elem->m_staffIdx == partNr && elem->m_voice == v) {
+            if (elem->m_staffIdx == partNr && elem->m_voice == ve.m_voice) {
                 dump_note_timing_measure_elem(elem, "xxx_voice_timing");
             }
         }
@@ -970,27 +450,16 @@ void MxmlConverter::measure(const int partNr, const size_t measureNr)
 
     barlineLeft(partNr, measureNr);
 
-    // Check for time signature change
-    bool timeSigChanged = false;
-    if (measureNr > 0) {
-        const auto& prevM = m_ef.measures().at(measureNr - 1);
-        if (m.m_timeSigNum != prevM.m_timeSigNum || m.m_timeSigDen != prevM.m_timeSigDen) {
-            timeSigChanged = true;
-        }
-    }
-
     if (measureNr == 0)
         attributes(partNr);
-    else if (keyCh || timeSigChanged) {
+    else if (info.m_keyChanged || info.m_timeSigChanged) {
         // Write attributes with key change and/or time signature change
         m_writer.writeElementStart("attributes");
-        if (keyCh) {
-            quint8 kcType = keyCh->m_tipo;
-            m_currentFifths = encKeyToFifths(kcType);
-            m_writer.writeKey(m_currentFifths);
-            qDebug() << "writeKeyChange" << "kcType" << kcType << "fifths" << m_currentFifths;
+        if (info.m_keyChanged) {
+            m_writer.writeKey(info.m_fifths);
+            qDebug() << "writeKeyChange" << "fifths" << info.m_fifths;
         }
-        if (timeSigChanged) {
+        if (info.m_timeSigChanged) {
             m_writer.writeTime(m.m_timeSigNum, m.m_timeSigDen);
             qDebug() << "writeTimeChange" << m.m_timeSigNum << "/" << m.m_timeSigDen;
         }
@@ -1008,184 +477,27 @@ void MxmlConverter::measure(const int partNr, const size_t measureNr)
         repeatLeft(m.repeat());
     }
 
-    // write notes and rests for all voices. As elem->m_tick sometimes differs slightly
-    // from the expected value, simply assume all voices start at tick = 0 and no gaps
-    // are present.
-
-    // Tracks filtered MIDI artifact tie-senders across all voices in this measure.
-    // A note with (grace1 & 0x0F) == 1 filtered by rdur<15 implies its receiver
-    // (grace1 & 0x0F == 2, same staff/voice/pitch) should also be filtered.
-    std::set<std::tuple<int,int,int>> filteredTieSenderPitches;
+    // write notes and rests for all voices, as normalised by the voice timeline
+    // Use time-signature-correct measure duration, not the raw MIDI m_durTicks.
+    // For MIDI-recorded files, m_durTicks can be a few ticks off from the
+    // theoretical value (e.g. 958 or 962 instead of 960 for 4/4).
+    const int measureDur = info.m_durTicks;
 
     int tick = 0;
-    for (const auto v : voices) {
-        TupletHandler th;  // Each voice has its own tuplet handler
-        // chordRootTick / chordRootTick2 track the tick of the last chord-root note
-        // in each pass (updated only for non-chord notes — no cascading).
-        // Used for chord detection: a note is a chord extension if its tick is within
-        // CHORD_MIDI_THRESHOLD of chordRootTick. This avoids cascading (chain detection)
-        // and handles MIDI-recorded chords where simultaneous notes land at ticks 0,1,2,...
-        int chordRootTick = -999;   // first pass
-        int chordRootTick2 = -999;  // second pass
+    for (const auto& ve : voices) {
         if (tick > 0) {
             // explicit backup to prevent error message at start of voice
             m_writer.writeBackupForward(-tick, 0);
             tick = 0;
         }
 
-        // Use time-signature-correct measure duration, not the raw MIDI m_durTicks.
-        // For MIDI-recorded files, m_durTicks can be a few ticks off from the
-        // theoretical value (e.g. 958 or 962 instead of 960 for 4/4).
-        const int measureDur = theoreticalDurTicks(m);
-
-        // First pass: collect valid elements, applying MIDI artifact filter.
-        // The filter skips notes with realDuration < 15 that Encore records as
-        // MIDI ghost notes (not displayed in the score).
-        std::vector<EncMeasureElem*> voiceElems;
-        for (const auto& elem : m.measureElems()) {
-            if (elem->m_staffIdx == partNr && elem->m_voice == v) {
-                if (elem->m_tick > measureDur) continue;  // Skip garbage
-                if (const auto* note = dynamic_cast<const EncMeasureElemNote*>(elem)) {
-                    // isChord: is this note a chord extension of the current chord root?
-                    // Uses CHORD_MIDI_THRESHOLD so MIDI-recorded chords (notes at ticks
-                    // 0,1,2,3...) are grouped correctly without overflowing the measure.
-                    const bool isChord = isChordOf(chordRootTick, note);
-                    if (!isChord) {
-                        // Skip if the measure is already full, OR if this note's written
-                        // duration would overflow it.  The second check prevents a single
-                        // long-realDuration note (e.g. a MIDI-recorded dotted half at
-                        // beat 3 of a 4/4 bar) from pushing tick past m_durTicks.
-                        const int noteDur = durationNote(note);
-                        if (tick >= measureDur || tick + noteDur > measureDur)
-                            continue;
-                    }
-
-                    // Update chordRootTick before filter checks (as MuseScore does with
-                    // prevMidiTick): even filtered notes establish the root for subsequent
-                    // chord-extension detection.
-                    if (!isChord)
-                        chordRootTick = (int)note->m_tick;
-
-                    // MIDI artifact filter
-                    if (note->m_realDuration > 0 && note->m_realDuration < 15) {
-                        const quint8 fv = note->m_faceValue & 0x0F;
-                        const int fvBase = faceValue2duration(fv);
-                        if (fvBase <= 15) {
-                            // 64th/128th notes: filter unless tie-start or chord extension
-                            if (!m_nc.tieStart(note) && !isChord) {
-                                if ((note->m_grace1 & 0x0F) == 1)
-                                    filteredTieSenderPitches.insert(
-                                        { partNr, (int)v, (int)note->m_semiTonePitch });
-                                continue;
-                            }
-                        } else {
-                            // Longer face values: filter unless at the chord-cluster boundary
-                            // (realDuration <= CHORD_CLUSTER_THRESHOLD means it may be a
-                            // live-recorded chord root whose cluster partner fell just outside)
-                            if (note->m_realDuration > CHORD_CLUSTER_THRESHOLD)
-                                continue;
-                        }
-                    }
-
-                    // Cascade filter: tie-receiver whose sender was filtered
-                    if ((note->m_grace1 & 0x0F) == 2) {
-                        auto key = std::make_tuple(partNr, (int)v, (int)note->m_semiTonePitch);
-                        if (filteredTieSenderPitches.count(key)) {
-                            filteredTieSenderPitches.erase(key);
-                            continue;
-                        }
-                    }
-
-                    voiceElems.push_back(elem);
-                    tick += isChord ? 0 : durationNote(note);
-                }
-                else if (const auto* rest = dynamic_cast<const EncMeasureElemRest*>(elem)) {
-                    int restDur = durationRest(rest);
-                    if (restDur <= 0) continue;  // Skip invalid rests
-                    if (tick + restDur > measureDur) continue;  // Skip rests that overflow
-                    chordRootTick = (int)elem->m_tick;
-                    voiceElems.push_back(elem);
-                    tick += restDur;
-                }
-            }
-        }
-
-        // Reset for second pass
-        tick = 0;
-        chordRootTick2 = -999;  // reset for second pass
-        int lastRootDur = 0;    // duration of last root note (for chord note <duration>)
-
-        // Second pass: write elements with proper tuplet handling
-        for (size_t i = 0; i < voiceElems.size(); ++i) {
-            const auto& elem = voiceElems[i];
-
-            // Check if next NON-CHORD element is a tuplet note (for closing current tuplet)
-            bool nextNonChordIsTuplet = false;
-            bool isLastNonChordInMeasure = true;
-            const EncMeasureElemNote* curAsNote = dynamic_cast<const EncMeasureElemNote*>(elem);
-            for (size_t j = i + 1; j < voiceElems.size(); ++j) {
-                if (const auto* nextNote = dynamic_cast<const EncMeasureElemNote*>(voiceElems[j])) {
-                    // Skip chord notes (use curAsNote's tick as the root for lookahead)
-                    if (curAsNote && isChordOf((int)curAsNote->m_tick, nextNote)) {
-                        continue;
-                    }
-                    // Use same detection as note(): check stored actualNotes first,
-                    // then detectTuplet (for MIDI-recorded files where actual/normal == 0)
-                    int nextActual = nextNote->actualNotes();
-                    if (nextActual == 0) {
-                        int dummy = 0;
-                        nextActual = detectTuplet(durationNote(nextNote), nextNote->m_faceValue, dummy);
-                    }
-                    nextNonChordIsTuplet = (nextActual > 0);
-                    isLastNonChordInMeasure = false;
-                    break;
-                }
-                else if (const auto* nextRest = dynamic_cast<const EncMeasureElemRest*>(voiceElems[j])) {
-                    int nextActual = nextRest->actualNotes();
-                    if (nextActual == 0) {
-                        int dummy = 0;
-                        nextActual = detectTuplet(durationRest(nextRest), nextRest->m_faceValue, dummy);
-                    }
-                    nextNonChordIsTuplet = (nextActual > 0);
-                    isLastNonChordInMeasure = false;
-                    break;
-                }
-            }
-
-            int duration = 0;
-            if (const EncMeasureElemNote* const curnote = dynamic_cast<const EncMeasureElemNote* const>(elem)) {
-                // Same chord detection as first pass: compare to chord root, not previous note.
-                const int savedChordRootTick2 = chordRootTick2;
-                const bool isChord = isChordOf(chordRootTick2, curnote);
-                if (!isChord)
-                    chordRootTick2 = (int)curnote->m_tick;
-
-                // Second-pass overflow guard: a note that was accepted by the first pass as a
-                // chord extension (isChord=true → no overflow check) may appear as a root here
-                // if chordRootTick2 differs from chordRootTick (they can diverge when elements
-                // filtered in the first pass alter chordRootTick but not chordRootTick2).
-                // Skip root notes whose written duration would push past the measure boundary.
-                if (!isChord) {
-                    const int nd = durationNote(curnote);
-                    if (tick + nd > measureDur) {
-                        chordRootTick2 = savedChordRootTick2;  // undo root update
-                        continue;
-                    }
-                }
-
-                // Do NOT use raw elem->m_tick for positioning within a voice.
-                // MuseScore's importer uses cumTick (written duration) exclusively;
-                // MIDI timing from e->tick is only used for chord detection.
-                // Writing <forward> elements based on elem->m_tick introduces MIDI
-                // jitter and, critically, MuseScore does NOT count <forward> toward
-                // the voice's duration — only actual note/rest elements count.
-                (void)elem->m_tick;
-
+        for (const auto& ev : ve) {
+            if (const auto curnote = ev.m_note) {
                 const auto direction = m_nc.direction(curnote);
                 if (direction
                     && direction->type() == ornamentType::STAFFTEXT
                     && direction->m_tind < m_ef.text().m_texts.size()) {
-                    m_writer.writeWords(m_ef.text().m_texts.at(direction->m_tind));
+                    m_writer.writeWords(toQString(m_ef.text().m_texts.at(direction->m_tind)));
                 }
                 else if (direction
                          && direction->type() == ornamentType::TEMPO) {
@@ -1203,47 +515,89 @@ void MxmlConverter::measure(const int partNr, const size_t measureNr)
                                         : WedgeType::CRESCENDO);
                 }
 
-                bool forceCloseTuplet = th.needsClose() && (!nextNonChordIsTuplet || isLastNonChordInMeasure);
-                note(curnote, partNr, th, isChord, forceCloseTuplet, tick, lastRootDur);
-                duration = isChord ? 0 : durationNote(curnote);
-                if (!isChord) lastRootDur = duration;
+                note(ev, partNr, info.m_fifths);
 
                 if (wedgeStop) {
                     m_writer.writeWedge(WedgeType::STOP);
                 }
             }
-            else if (const EncMeasureElemRest* const currest = dynamic_cast<const EncMeasureElemRest* const>(elem)) {
-                chordRootTick2 = (int)elem->m_tick;
-                bool forceCloseTuplet = th.needsClose() && (!nextNonChordIsTuplet || isLastNonChordInMeasure);
-                rest(currest, partNr, th, forceCloseTuplet, tick);
-                duration = durationRest(currest);
+            else if (ev.m_rest) {
+                rest(ev, partNr);
             }
-            tick += duration;
         }
+        tick = ve.m_endTick;
 
         // Fill any remaining gap to the measure boundary with a rest so that
         // MuseScore counts the gap toward the voice duration (<forward> elements
         // are ignored by MuseScore for this purpose).
         if (tick < measureDur) {
             const int gap = measureDur - tick;
-            m_writer.writeGapRest(gap, v, nstaves(partNr) > 1 ? 1 : 0);
+            m_writer.writeGapRest(gap, ve.m_voice, nstaves(partNr) > 1 ? 1 : 0);
             tick = measureDur;
         }
-
-        // Reset tuplet handler state for next voice
-        if (th.needsClose()) {
-            th.close();
-        }
     }
 
     if (partNr == 0) {
         // write repeat only for first staff
-        m_writer.writeRepeatRight(encRepeatToWords(m.repeat()));
+        m_writer.writeRepeatRight(info.m_repeatWords);
     }
 
     barlineRight(partNr, measureNr);
+}
 
-    m_writer.writeElementEnd();
+
+//---------------------------------------------------------
+// measureConverted - report a written measure to the observer
+// returns false if the conversion must stop
+//---------------------------------------------------------
+
+bool MxmlConverter::measureConverted(const int xmlPartNr, const size_t measureNr)
+{
+    m_progress.m_partNr = xmlPartNr;
+    m_progress.m_measureNr = measureNr;
+    ++m_progress.m_measuresDone;
+    if (m_observer) {
+        m_progress.m_elapsed = m_timer.elapsed();
+        m_observer->measureConverted(m_progress);
+    }
+    m_cancelled = m_token && m_token->isCancelled();
+    return !m_cancelled;
+}
+
+
+//---------------------------------------------------------
+// measures - write all measures, each containing all parts (timewise)
+// requires a single pass over the measures only
+// all parts are completed by the last measure, the observer is
+// told about each part then
+//---------------------------------------------------------
+
+void MxmlConverter::measures()
+{
+    for (size_t i = 0; i < m_ef.measures().size(); ++i) {
+        if (m_cancelled)
+            return;
+        m_writer.writeElementStartWithAttribute("measure", "number", i + 1);
+        int xmlPartNr = 0;
+        for (unsigned int count = 0; count < m_ef.staves().size(); ++count) {
+            if (isTablature(count) || isHidden(count))
+                continue;
+            ++xmlPartNr;
+            m_writer.writeElementStartWithAttribute("part", "id", QString("P%1").arg(xmlPartNr));
+            measureContents(count, i);
+            m_writer.writeElementEnd();
+            if (!measureConverted(xmlPartNr, i))
+                break;
+        }
+        m_writer.writeElementEnd();
+    }
+    if (m_observer && !m_cancelled) {
+        for (int xmlPartNr = 1; xmlPartNr <= m_progress.m_partCount; ++xmlPartNr) {
+            m_progress.m_partNr = xmlPartNr;
+            m_progress.m_elapsed = m_timer.elapsed();
+            m_observer->partConverted(m_progress);
+        }
+    }
 }
 
 
@@ -1251,19 +605,19 @@ void MxmlConverter::measure(const int partNr, const size_t measureNr)
 // note - write a note
 //---------------------------------------------------------
 
-void MxmlConverter::note(const EncMeasureElemNote* const note, const int partNr, TupletHandler& th, const bool chord, const bool forceCloseTuplet, const int calculatedTick, const int chordRootDur)
+void MxmlConverter::note(const VoiceEvent& ev, const int partNr, const int fifths)
 {
+    const auto note = ev.m_note;
+    const bool chord = ev.m_chord;
     char step = ' ';
     int alter = 0;
     int octave = 0;
-    // For chord notes, use the chord root's duration so that the MusicXML importer's
-    // measure-duration accumulation (mDura in pass 1) does not double-count chord notes
-    // that have different durations from their root (e.g. triplet 8th extension of a
-    // quarter root in a MIDI-recorded chord cluster).
-    const int noteDur = (chord && chordRootDur > 0) ? chordRootDur : durationNote(note);
-
-    // Use current key signature (tracked through key changes) for pitch spelling
-    midipitch2xml(note->m_semiTonePitch, static_cast<accidentalType>(note->m_alterationGlyph), m_currentFifths, step, alter, octave);
+
+    // Use the key signature in effect in this measure for pitch spelling
+    const auto accid = static_cast<accidentalType>(note->m_alterationGlyph);
+    midipitch2xml(note->m_semiTonePitch, accid, fifths, step, alter, octave);
+    qDebug("xxx_midipitch2xml(pitch %d, accid %d, fifths %d) step %c, alter %d, octave %d",
+           note->m_semiTonePitch, static_cast<unsigned int>(accid), fifths, step, alter, octave);
     m_writer.writeElementStart("note");
 
     m_writer.writeGrace(note->graceType());
@@ -1275,7 +629,7 @@ void MxmlConverter::note(const EncMeasureElemNote* const note, const int partNr,
     m_writer.writePitch(step, alter, octave);
 
     if (!isGrace(note)) {
-        m_writer.writeElement("duration", noteDur);
+        m_writer.writeElement("duration", ev.m_noteDuration);
     }
 
     const bool tieStart = m_nc.tieStart(note);
@@ -1289,29 +643,12 @@ void MxmlConverter::note(const EncMeasureElemNote* const note, const int partNr,
     }
 
     m_writer.writeVoice(hasMultipleVoices(partNr), note->m_voice + 1);
-    m_writer.writeElement("type", correctNoteType(noteDur, note->m_faceValue));
-    // Always calculate dots from written duration (m_dotControl is unreliable in old format files)
-    const int noteDots = calculateDots(noteDur, note->m_faceValue);
-    m_writer.writeDots(noteDots);
-
-    // Detect tuplet from duration if not set in file
-    int noteActual = note->actualNotes();
-    int noteNormal = note->normalNotes();
-    if (noteActual == 0 && noteDur > 0) {
-        noteActual = detectTuplet(noteDur, note->m_faceValue, noteNormal);
-    }
-    m_writer.writeTimeModification(noteActual, noteNormal);
+    m_writer.writeElement("type", faceValue2xml(ev.m_type));
+    m_writer.writeDots(ev.m_dots);
+
+    m_writer.writeTimeModification(ev.m_actualNotes, ev.m_normalNotes);
     m_writer.writeStaff(nstaves(partNr), (note->m_voice < 4) ? 1 : 2);
-    // Don't count chord notes for tuplet state - they're simultaneous with the previous note
-    // Use calculated tick for proper grouping (m_tick from Encore can be inconsistent)
-    auto tupletState = chord ? TupletState::NONE : th.newNote(noteActual, noteNormal, calculatedTick, noteDur);
-    // Force close tuplet if this is the last tuplet note before a non-tuplet or end of measure
-    // But NOT for chord notes - they shouldn't carry tuplet brackets
-    if (forceCloseTuplet && !chord && tupletState == TupletState::NONE && th.needsClose()) {
-        tupletState = TupletState::STOP;
-        th.close();
-    }
-    m_writer.writeTuplet(tupletState);
+    m_writer.writeTuplet(ev.m_tupletState);
 
 
     const auto slurstart = m_nc.slurStart(note);
@@ -1349,9 +686,16 @@ void MxmlConverter::part(const int encPartNr, const int xmlPartNr)
 {
     const QString partId = QString("P%1").arg(xmlPartNr);
     m_writer.writeElementStartWithAttribute("part", "id", partId);
-    for (unsigned int i = 0; i < m_ef.measures().size(); ++i)
+    for (unsigned int i = 0; i < m_ef.measures().size(); ++i) {
         measure(encPartNr, i);
+        if (!measureConverted(xmlPartNr, i))
+            break;
+    }
     m_writer.writeElementEnd();
+    if (m_observer && !m_cancelled) {
+        m_progress.m_elapsed = m_timer.elapsed();
+        m_observer->partConverted(m_progress);
+    }
 }
 
 
@@ -1387,6 +731,8 @@ void MxmlConverter::parts()
     for (unsigned int count = 0; count < m_ef.staves().size(); ++count) {
         if (isTablature(count) || isHidden(count))
             continue;
+        if (m_cancelled)
+            return;
         ++xmlPartNr;
         part(count, xmlPartNr);
     }
@@ -1410,33 +756,20 @@ void MxmlConverter::repeatLeft(const repeatType repeat)
 // rest - write a rest
 //---------------------------------------------------------
 
-void MxmlConverter::rest(const EncMeasureElemRest* const rest, const int partNr, TupletHandler &th, const bool forceCloseTuplet, const int calculatedTick)
+void MxmlConverter::rest(const VoiceEvent& ev, const int partNr)
 {
-    const int restDur = durationRest(rest);  // Calculate duration once for consistency
+    const auto rest = ev.m_rest;
 
     m_writer.writeElementStart("note");
     m_writer.writeElement("rest");
-    m_writer.writeElement("duration", restDur);
+    m_writer.writeElement("duration", ev.m_noteDuration);
     m_writer.writeVoice(hasMultipleVoices(partNr), rest->m_voice + 1);
-    // Use correctNoteType to fix type when duration doesn't match faceValue (common Encore bug)
-    m_writer.writeElement("type", correctNoteType(restDur, rest->m_faceValue));
-    // Always calculate dots from actual duration (m_dotControl is unreliable in old format files)
-    const int restDots = calculateDots(restDur, rest->m_faceValue);
-    m_writer.writeDots(restDots);
-
-    // Use explicit tuplet info from Encore (don't auto-detect for rests)
-    const int restActual = rest->actualNotes();
-    const int restNormal = rest->normalNotes();
-    m_writer.writeTimeModification(restActual, restNormal);
+    m_writer.writeElement("type", faceValue2xml(ev.m_type));
+    m_writer.writeDots(ev.m_dots);
+
+    m_writer.writeTimeModification(ev.m_actualNotes, ev.m_normalNotes);
     m_writer.writeStaff(nstaves(partNr), (rest->m_voice < 4) ? 1 : 2);
-    // Use calculated tick for proper grouping (m_tick from Encore can be inconsistent)
-    auto tupletState = th.newNote(restActual, restNormal, calculatedTick, restDur);
-    // Force close tuplet if this is the last tuplet note before a non-tuplet or end of measure
-    if (forceCloseTuplet && tupletState == TupletState::NONE && th.needsClose()) {
-        tupletState = TupletState::STOP;
-        th.close();
-    }
-    m_writer.writeTuplet(tupletState);
+    m_writer.writeTuplet(ev.m_tupletState);
     m_writer.writeElementEnd();
 }
 
@@ -1447,7 +780,7 @@ void MxmlConverter::rest(const EncMeasureElemRest* const rest, const int partNr,
 
 void MxmlConverter::scorePart(const int n, const EncInstrument &instr)
 {
-    m_writer.writeScorePart(n, instr.m_name, instr.m_midiProgram);
+    m_writer.writeScorePart(n, toQString(instr.m_name), instr.m_midiProgram);
 }
 
 
@@ -1473,5 +806,5 @@ void MxmlConverter::work()
 {
     const EncTitle& enctitle = m_ef.title();
     const auto subtitle = createMultiLineString(enctitle.m_subtitle);
-    m_writer.writeWork(enctitle.m_title, subtitle);
+    m_writer.writeWork(toQString(enctitle.m_title), subtitle);
 }
@@ -20,25 +20,63 @@
 #ifndef MXMLCONVERTER_H
 #define MXMLCONVERTER_H
 
+#include <atomic>
+#include <vector>
+
+#include <QElapsedTimer>
+
 #include "commondefs.h"
 #include "mxmlwriter.h"
 #include "noteconnector.h"
+#include "scoretimeline.h"
+#include "voicetimeline.h"
+
+//---------------------------------------------------------
+// the progress of a conversion, as reported to an observer
+//---------------------------------------------------------
+
+struct ConversionProgress
+{
+    int     m_partNr            { 0 };      // MusicXML part number (1-based)
+    int     m_partCount         { 0 };      // number of parts written
+    size_t  m_measureNr         { 0 };      // measure index (0-based)
+    size_t  m_measureCount      { 0 };      // number of measures per part
+    size_t  m_measuresDone      { 0 };      // measures written, counted over all parts
+    size_t  m_measuresTotal     { 0 };      // m_partCount * m_measureCount
+    qint64  m_elapsed           { 0 };      // milliseconds since the conversion started
+};
+
 
 //---------------------------------------------------------
-// the tuplet state handler deduces tuplet start and stop notes
-// Groups tuplets by counting notes until actualNotes is reached
+// an observer receives the progress of a conversion
+// both functions are called from the thread running the conversion:
+// measureConverted() after each measure of each part written,
+// partConverted() after the last measure of a part (timewise: after
+// the last measure, once for each part)
 //---------------------------------------------------------
 
-class TupletHandler {
+class ConversionObserver
+{
+public:
+    virtual ~ConversionObserver() = default;
+    virtual void measureConverted(const ConversionProgress&) {}
+    virtual void partConverted(const ConversionProgress&) {}
+};
+
+
+//---------------------------------------------------------
+// a cancellation token can be cancelled from any thread,
+// the converter checks it at each measure boundary
+//---------------------------------------------------------
+
+class CancellationToken
+{
 public:
-    TupletHandler() {}
-    TupletState newNote(const quint8 actualNotes, const quint8 normalNotes, const int tick, const int duration);
-    bool needsClose() const { return m_inTuplet; }
-    void close() { m_inTuplet = false; m_groupStartTick = -1; m_groupDuration = 0; }
+    void cancel() { m_cancelled = true; }
+    void reset() { m_cancelled = false; }
+    bool isCancelled() const { return m_cancelled; }
 private:
-    bool m_inTuplet { false };
-    int m_groupStartTick { -1 };
-    int m_groupDuration { 0 };
+    std::atomic<bool> m_cancelled { false };
 };
 
 
@@ -51,7 +89,10 @@ class MxmlConverter
 {
 public:
     MxmlConverter(const EncFile& ef, QIODevice* device);
-    void convertEncToMxml();
+    MxmlConverter(const EncFile& ef, NoteConnector&& nc, QIODevice* device);
+    bool convertEncToMxml(const bool timewise = false);
+    void setObserver(ConversionObserver* observer) { m_observer = observer; }
+    void setCancellationToken(const CancellationToken* token) { m_token = token; }
 private:
     bool hasMultipleVoices(const int partNr) const { return (partNr < static_cast<int>(m_voicesPerPart.size())) && (m_voicesPerPart.at(partNr) > 1); }
     int nstaves(const int partNr) const { return (partNr < static_cast<int>(m_ef.staves().size())) ? m_ef.staves().at(partNr).m_nstaves : 1; }
@@ -66,21 +107,30 @@ private:
     void key();
     void keyChange(const EncMeasureElemKeyChange* keyCh);
     void measure(const int partNr, const size_t measureNr);
-    void note(const EncMeasureElemNote* const note, const int partNr, TupletHandler &th, const bool chord, const bool forceCloseTuplet, const int calculatedTick, const int chordRootDur = 0);
+    void measureContents(const int partNr, const size_t measureNr);
+    bool measureConverted(const int xmlPartNr, const size_t measureNr);
+    void measures();
+    void note(const VoiceEvent& ev, const int partNr, const int fifths);
     void part(const int encPartNr, const int xmlPartNr);
     void partList();
     void parts();
     void repeatLeft(const repeatType repeat);
-    void rest(const EncMeasureElemRest* const rest, const int partNr, TupletHandler &th, const bool forceCloseTuplet, const int calculatedTick);
+    void rest(const VoiceEvent& ev, const int partNr);
     void scorePart(const int n, const EncInstrument& instr);
     void time();
     void work();
     QIODevice* m_device;
     const EncFile& m_ef;
     const NoteConnector m_nc;
+    const ScoreTimeline m_timeline;
+    VoiceTimeline m_voiceTimeline;
     MxmlWriter m_writer;
     std::vector<std::size_t> m_voicesPerPart;
-    int m_currentFifths { 0 };  // Current key signature for pitch spelling
+    ConversionObserver* m_observer { nullptr };
+    const CancellationToken* m_token { nullptr };
+    ConversionProgress m_progress;
+    QElapsedTimer m_timer;
+    bool m_cancelled { false };
 };
 
 #endif // MXMLCONVERTER_H
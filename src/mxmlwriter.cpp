@@ -119,12 +119,17 @@ void MxmlWriter::writeBarlineRight(const bool repeatEnd, const bool endingStop,
 // writeBegin - begin writing: creates the header
 //---------------------------------------------------------
 
-void MxmlWriter::writeBegin()
+void MxmlWriter::writeBegin(const bool timewise)
 {
     m_xml.writeStartDocument();
-    m_xml.writeDTD("<!DOCTYPE score-partwise PUBLIC "
-                   "\"-//Recordare//DTD MusicXML 3.1 Partwise//EN\" "
-                   "\"http://www.musicxml.org/dtds/partwise.dtd\">");
+    if (timewise)
+        m_xml.writeDTD("<!DOCTYPE score-timewise PUBLIC "
+                       "\"-//Recordare//DTD MusicXML 3.1 Timewise//EN\" "
+                       "\"http://www.musicxml.org/dtds/timewise.dtd\">");
+    else
+        m_xml.writeDTD("<!DOCTYPE score-partwise PUBLIC "
+                       "\"-//Recordare//DTD MusicXML 3.1 Partwise//EN\" "
+                       "\"http://www.musicxml.org/dtds/partwise.dtd\">");
 }
 
 
@@ -38,7 +38,7 @@ public:
     void writeBackupForward(const int duration, const int voice);
     void writeBarlineLeft(const bool repeatStart, const bool endingStart, const bool barlineDblLeft, const QString& endingNumber);
     void writeBarlineRight(const bool repeatEnd, const bool endingStop, const bool barlineEnd, const bool barlineDbl, const int repeatAlternative);
-    void writeBegin();
+    void writeBegin(const bool timewise = false);
     void writeClef(const int number, const QString& sign, const int line, const int octCh);
     void writeDivisions(const int divisions);
     void writeDots(const int dots);
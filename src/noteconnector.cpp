@@ -22,6 +22,7 @@
 // and ties
 //---------------------------------------------------------
 
+#include <algorithm>
 #include <climits>
 #include <cmath>
 
@@ -31,9 +32,92 @@
 
 
 //---------------------------------------------------------
-//  -
+// NoteXoffsetIndex
 //---------------------------------------------------------
 
+/*
+ * A scan in measure order returns the first note with the smallest distance
+ * (closest), the last note before xoffset (lastBefore) or the first note after
+ * xoffset (firstAfter). Stable sorting keeps notes with equal xoffset in measure
+ * order, and the prefix / suffix tables give the latest resp. earliest note in
+ * measure order within a range of xoffsets, so the results are identical.
+ */
+
+void NoteXoffsetIndex::sort()
+{
+    std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& e1, const Entry& e2) {
+        return e1.m_note->m_xoffset < e2.m_note->m_xoffset;
+    });
+
+    const size_t n = m_entries.size();
+    m_lastUpTo.resize(n);
+    m_firstFrom.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_lastUpTo[i] = (i > 0 && m_entries[m_lastUpTo[i - 1]].m_order > m_entries[i].m_order) ? m_lastUpTo[i - 1] : i;
+    }
+    for (size_t i = n; i-- > 0;) {
+        m_firstFrom[i] = (i + 1 < n && m_entries[m_firstFrom[i + 1]].m_order < m_entries[i].m_order) ? m_firstFrom[i + 1] : i;
+    }
+}
+
+
+// groupStart - first entry with an xoffset not less than xoffset
+
+std::vector<NoteXoffsetIndex::Entry>::const_iterator NoteXoffsetIndex::groupStart(const int xoffset) const
+{
+    return std::lower_bound(m_entries.cbegin(), m_entries.cend(), xoffset, [](const Entry& e, const int x) {
+        return e.m_note->m_xoffset < x;
+    });
+}
+
+
+// closest - first note in measure order with the smallest distance to xoffset
+
+const EncMeasureElemNote* NoteXoffsetIndex::closest(const int xoffset) const
+{
+    const auto upper = groupStart(xoffset);
+    if (upper == m_entries.cbegin()) {
+        return upper != m_entries.cend() ? upper->m_note : nullptr;
+    }
+    // first entry of the group with the largest xoffset below xoffset
+    const auto lower = groupStart((upper - 1)->m_note->m_xoffset);
+    if (upper == m_entries.cend()) {
+        return lower->m_note;
+    }
+    const int lowerDistance = xoffset - lower->m_note->m_xoffset;
+    const int upperDistance = upper->m_note->m_xoffset - xoffset;
+    if (lowerDistance != upperDistance) {
+        return lowerDistance < upperDistance ? lower->m_note : upper->m_note;
+    }
+    return lower->m_order < upper->m_order ? lower->m_note : upper->m_note;
+}
+
+
+// firstAfter - first note in measure order with an xoffset larger than xoffset
+
+const EncMeasureElemNote* NoteXoffsetIndex::firstAfter(const int xoffset) const
+{
+    const auto it = std::upper_bound(m_entries.cbegin(), m_entries.cend(), xoffset, [](const int x, const Entry& e) {
+        return x < e.m_note->m_xoffset;
+    });
+    if (it == m_entries.cend()) {
+        return nullptr;
+    }
+    return m_entries.at(m_firstFrom.at(it - m_entries.cbegin())).m_note;
+}
+
+
+// lastBefore - last note in measure order with an xoffset smaller than xoffset
+
+const EncMeasureElemNote* NoteXoffsetIndex::lastBefore(const int xoffset) const
+{
+    const auto it = groupStart(xoffset);
+    if (it == m_entries.cbegin()) {
+        return nullptr;
+    }
+    return m_entries.at(m_lastUpTo.at(it - m_entries.cbegin() - 1)).m_note;
+}
+
 
 //---------------------------------------------------------
 // NoteConnector
@@ -43,6 +127,8 @@ NoteConnector::NoteConnector(const EncFile& ef)
     : m_ef(ef)
 {
     initMeasureNumbers();
+    initDirections();
+    initNoteIndex();
     for (unsigned int measureNr = 0; measureNr < m_ef.measures().size(); ++measureNr) {
         const auto& m = m_ef.measures().at(measureNr);
         for (const auto elem : m.measureElems()) {
@@ -74,6 +160,65 @@ void NoteConnector::initMeasureNumbers()
 }
 
 
+//---------------------------------------------------------
+// initDirections - cache the direction (staff text or tempo)
+// of each note, matched by staff, voice and tick in its measure
+//---------------------------------------------------------
+
+void NoteConnector::initDirections()
+{
+    // ornaments are not handled correctly for SCO5 files (many values incorrectly set to 0)
+    // -> temporarily disabled
+    if (m_ef.header().m_magic == "SCO5") {
+        return;
+    }
+
+    std::map<std::tuple<quint8, quint8, quint16>, const EncMeasureElemOrnament*> directions;  // key: staff, voice, tick
+    for (const auto& m : m_ef.measures()) {
+        directions.clear();
+        for (const auto elem : m.measureElems()) {
+            if (const EncMeasureElemOrnament* const orn = dynamic_cast<const EncMeasureElemOrnament* const>(elem)) {
+                if (orn->type() == ornamentType::STAFFTEXT || orn->type() == ornamentType::TEMPO) {
+                    // emplace keeps the first direction found, as the measure scan did
+                    directions.emplace(std::make_tuple(orn->m_staffIdx, orn->m_voice, orn->m_tick), orn);
+                }
+            }
+        }
+        if (directions.empty()) {
+            continue;
+        }
+        for (const auto elem : m.measureElems()) {
+            if (const EncMeasureElemNote* const note = dynamic_cast<const EncMeasureElemNote* const>(elem)) {
+                const auto resultPair = directions.find(std::make_tuple(note->m_staffIdx, note->m_voice, note->m_tick));
+                if (resultPair != directions.end()) {
+                    m_directions.emplace(note, resultPair->second);
+                }
+            }
+        }
+    }
+}
+
+
+//---------------------------------------------------------
+// initNoteIndex - build the per measure, staff and voice notes sorted by xoffset
+//---------------------------------------------------------
+
+void NoteConnector::initNoteIndex()
+{
+    for (size_t measureNr = 0; measureNr < m_ef.measures().size(); ++measureNr) {
+        const auto& m = m_ef.measures().at(measureNr);
+        for (const auto elem : m.measureElems()) {
+            if (const EncMeasureElemNote* const note = dynamic_cast<const EncMeasureElemNote* const>(elem)) {
+                m_noteIndex[std::make_tuple(measureNr, note->m_staffIdx, note->m_voice)].add(note);
+            }
+        }
+    }
+    for (auto& index : m_noteIndex) {
+        index.second.sort();
+    }
+}
+
+
 //---------------------------------------------------------
 // initSlur - initialize a slur's state
 //---------------------------------------------------------
@@ -145,56 +290,41 @@ size_t NoteConnector::measureNumber(const EncMeasureElem* const elem) const
 
 
 //---------------------------------------------------------
-// findClosestNote - find closest note to a given xpos
+// noteIndex - return the notes of voice in staff staffIdx in measure measureNr
+// or nullptr if there are none
 //---------------------------------------------------------
 
-const EncMeasureElemNote* NoteConnector::findClosestNote(const quint8 xoffset, const quint8 voice, const quint8 staffIdx, const size_t measureNr) const
+const NoteXoffsetIndex* NoteConnector::noteIndex(const quint8 voice, const quint8 staffIdx, const size_t measureNr) const
 {
-    // Bounds check
-    if (measureNr >= m_ef.measures().size()) {
-        return nullptr;
-    }
-    const EncMeasureElemNote* closestNote { nullptr };
-    int minimum { INT_MAX };
-    const auto& m = m_ef.measures().at(measureNr);
+    const auto resultPair = m_noteIndex.find(std::make_tuple(measureNr, staffIdx, voice));
 
-    for (const auto elem : m.measureElems()) {
-        if (const EncMeasureElemNote* const note = dynamic_cast<const EncMeasureElemNote* const>(elem)) {
-            if (note->m_voice == voice && note->m_staffIdx == staffIdx) {
-                const auto minimumCandidate = abs(xoffset - note->m_xoffset);
-                if (minimumCandidate < minimum) {
-                    minimum = minimumCandidate;
-                    closestNote = note;
-                }
-            }
-        }
+    if (resultPair != m_noteIndex.end()) {
+        return &resultPair->second;
     }
 
-    return closestNote;
+    return nullptr;
 }
 
 
 //---------------------------------------------------------
-// findFirstNoteAfterXoffset - find first note after a given xpos
+// findClosestNote - find closest note to a given xpos
 //---------------------------------------------------------
 
-const EncMeasureElemNote* NoteConnector::findFirstNoteAfterXoffset(const quint8 xoffset, const quint8 voice, const quint8 staffIdx, const size_t measureNr) const
+const EncMeasureElemNote* NoteConnector::findClosestNote(const quint8 xoffset, const quint8 voice, const quint8 staffIdx, const size_t measureNr) const
 {
-    // Bounds check
-    if (measureNr >= m_ef.measures().size()) {
-        return nullptr;
-    }
-    const auto& m = m_ef.measures().at(measureNr);
+    const auto index = noteIndex(voice, staffIdx, measureNr);
+    return index ? index->closest(xoffset) : nullptr;
+}
 
-    for (const auto elem : m.measureElems()) {
-        if (const EncMeasureElemNote* const note = dynamic_cast<const EncMeasureElemNote* const>(elem)) {
-            if (note->m_voice == voice && note->m_staffIdx == staffIdx && note->m_xoffset > xoffset) {
-                return note;
-            }
-        }
-    }
 
-    return nullptr;
+//---------------------------------------------------------
+// findFirstNoteAfterXoffset - find first note after a given xpos
+//---------------------------------------------------------
+
+const EncMeasureElemNote* NoteConnector::findFirstNoteAfterXoffset(const quint8 xoffset, const quint8 voice, const quint8 staffIdx, const size_t measureNr) const
+{
+    const auto index = noteIndex(voice, staffIdx, measureNr);
+    return index ? index->firstAfter(xoffset) : nullptr;
 }
 
 
@@ -231,22 +361,8 @@ const EncMeasureElemNote* NoteConnector::findLastNote(const EncMeasureElemNote*
 // last note before a given xpos
 const EncMeasureElemNote* NoteConnector::findLastNoteBeforeXoffset(const quint8 xoffset, const quint8 voice, const quint8 staffIdx, const size_t measureNr) const
 {
-    // Bounds check
-    if (measureNr >= m_ef.measures().size()) {
-        return nullptr;
-    }
-    const EncMeasureElemNote* lastNote { nullptr };
-    const auto& m = m_ef.measures().at(measureNr);
-
-    for (const auto elem : m.measureElems()) {
-        if (const EncMeasureElemNote* const note = dynamic_cast<const EncMeasureElemNote* const>(elem)) {
-            if (note->m_voice == voice && note->m_staffIdx == staffIdx && note->m_xoffset < xoffset) {
-                lastNote = note;
-            }
-        }
-    }
-
-    return lastNote;
+    const auto index = noteIndex(voice, staffIdx, measureNr);
+    return index ? index->lastBefore(xoffset) : nullptr;
 }
 
 
@@ -285,29 +401,10 @@ const EncMeasureElemNote* NoteConnector::findPreviousNote(const EncMeasureElemNo
 
 const EncMeasureElemOrnament* NoteConnector::direction(const EncMeasureElemNote* const note) const
 {
-    // ornaments are not handled correctly for SCO5 files (many values incorrectly set to 0)
-    // -> temporarily disabled
-    if (m_ef.header().m_magic == "SCO5") {
-        return nullptr;
-    }
-
-    const auto measureNr = measureNumber(note);
-    // Bounds check
-    if (measureNr >= m_ef.measures().size()) {
-        return nullptr;
-    }
-    const auto& m = m_ef.measures().at(measureNr);
+    const auto resultPair = m_directions.find(note);
 
-    for (const auto elem : m.measureElems()) {
-        if (const EncMeasureElemOrnament* const orn = dynamic_cast<const EncMeasureElemOrnament* const>(elem)) {
-            if (note->m_tick == orn->m_tick
-                && note->m_voice == orn->m_voice
-                && note->m_staffIdx == orn->m_staffIdx
-                && (orn->type() == ornamentType::STAFFTEXT
-                    || orn->type() == ornamentType::TEMPO)) {
-                return orn;
-            }
-        }
+    if (resultPair != m_directions.end()) {
+        return resultPair->second;
     }
 
     return nullptr;
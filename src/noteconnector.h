@@ -21,9 +21,38 @@
 #define NOTECONNECTOR_H
 
 #include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include "encfile.h"
 
+//---------------------------------------------------------
+// the notes of one voice in one staff in one measure, sorted by xoffset
+// answers the nearest, predecessor and successor queries with binary search,
+// returning the same note a scan in measure order would
+//---------------------------------------------------------
+
+class NoteXoffsetIndex
+{
+public:
+    void add(const EncMeasureElemNote* const note) { m_entries.push_back({ note, m_entries.size() }); }
+    void sort();
+    const EncMeasureElemNote* closest(const int xoffset) const;
+    const EncMeasureElemNote* firstAfter(const int xoffset) const;
+    const EncMeasureElemNote* lastBefore(const int xoffset) const;
+private:
+    struct Entry {
+        const EncMeasureElemNote* m_note;
+        size_t m_order;                 // position in measure order
+    };
+    std::vector<Entry>::const_iterator groupStart(const int xoffset) const;
+    std::vector<Entry> m_entries;       // sorted by xoffset, then measure order
+    std::vector<size_t> m_lastUpTo;     // m_lastUpTo[i]: entry in [0, i] latest in measure order
+    std::vector<size_t> m_firstFrom;    // m_firstFrom[i]: entry in [i, end) earliest in measure order
+};
+
+
 class NoteConnector
 {
 public:
@@ -41,12 +70,17 @@ private:
     const EncMeasureElemNote* findLastNote(const EncMeasureElemNote* const note, const size_t measureNr) const;
     const EncMeasureElemNote* findLastNoteBeforeXoffset(const quint8 xoffset, const quint8 voice, const quint8 staffIdx, const size_t measureNr) const;
     const EncMeasureElemNote* findPreviousNote(const EncMeasureElemNote* const note, const size_t measureNr) const;
+    void initDirections();
     void initMeasureNumbers();
+    void initNoteIndex();
     void initSlur(const EncMeasureElemOrnament* const orn, const size_t measureNr);
     void initWedge(const EncMeasureElemOrnament* const orn, const size_t measureNr);
     size_t measureNumber(const EncMeasureElem* const elem) const;
+    const NoteXoffsetIndex* noteIndex(const quint8 voice, const quint8 staffIdx, const size_t measureNr) const;
     const EncFile& m_ef;
+    std::unordered_map<const EncMeasureElemNote*, const EncMeasureElemOrnament*> m_directions;  // only notes with a direction
     std::map<const EncMeasureElem* const, const size_t> m_measureElemToMeasureNr;
+    std::map<std::tuple<size_t, quint8, quint8>, NoteXoffsetIndex> m_noteIndex;  // key: measure, staff, voice
     std::map<const EncMeasureElemNote* const, const EncMeasureElemOrnament* const> m_slurStarts;
     std::map<const EncMeasureElemNote* const, const EncMeasureElemOrnament* const> m_slurStops;
     std::map<const EncMeasureElemNote* const, const EncMeasureElemOrnament* const> m_wedgeStarts;
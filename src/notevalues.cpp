@@ -0,0 +1,366 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <algorithm>
+#include <utility>
+
+#include <QtDebug>
+
+#include "notevalues.h"
+
+
+//---------------------------------------------------------
+// calculateDots - calculate number of dots from duration and faceValue
+// A dotted note has duration = base * 1.5, double dotted = base * 1.75, etc.
+//---------------------------------------------------------
+
+int calculateDots(const int realDuration, const quint8 faceValue)
+{
+    int baseDuration = faceValue2duration(faceValue & 0x0F);
+    if (baseDuration <= 0 || realDuration <= 0) {
+        return 0;
+    }
+
+    // Check for dotted durations
+    // 1 dot: base * 3/2 = base * 1.5
+    // 2 dots: base * 7/4 = base * 1.75
+    // 3 dots: base * 15/8 = base * 1.875
+
+    if (realDuration == baseDuration) {
+        return 0;
+    } else if (realDuration == (baseDuration * 3) / 2) {
+        return 1;
+    } else if (realDuration == (baseDuration * 7) / 4) {
+        return 2;
+    } else if (realDuration == (baseDuration * 15) / 8) {
+        return 3;
+    }
+
+    return 0;
+}
+
+
+//---------------------------------------------------------
+// detectTuplet - detect tuplet from duration and faceValue
+// Returns actual notes (3 for triplet), 0 if not a tuplet
+// Sets normalNotes through output parameter
+//---------------------------------------------------------
+
+int detectTuplet(const int realDuration, const quint8 faceValue, int& normalNotes)
+{
+    int baseDuration = faceValue2duration(faceValue & 0x0F);
+    if (baseDuration <= 0 || realDuration <= 0) {
+        normalNotes = 0;
+        return 0;
+    }
+
+    // Triplet (3:2): duration = base * 2/3
+    // e.g., eighth note base=120, triplet eighth=80
+    if (realDuration == (baseDuration * 2) / 3) {
+        normalNotes = 2;
+        return 3;
+    }
+
+    // Quintuplet (5:4): duration = base * 4/5
+    if (realDuration == (baseDuration * 4) / 5) {
+        normalNotes = 4;
+        return 5;
+    }
+
+    // Sextuplet (6:4): duration = base * 4/6 = base * 2/3 (same as triplet)
+    // Already covered by triplet case
+
+    normalNotes = 0;
+    return 0;
+}
+
+
+//---------------------------------------------------------
+// faceValue2xml - convert Encore to MusicXML note type
+// the type strings are created once and shared by all notes
+//---------------------------------------------------------
+
+const QString& faceValue2xml(const quint8 faceValue)
+{
+    static const std::array<QString, FACEVALUE_COUNT> types = [] {
+        std::array<QString, FACEVALUE_COUNT> res;
+        for (size_t i = 0; i < res.size(); ++i)
+            res[i] = QString::fromLatin1(faceValueXmlTypes[i]);
+        return res;
+    }();
+    return types[faceValue < FACEVALUE_COUNT ? faceValue : 0];
+}
+
+
+//---------------------------------------------------------
+// faceValue2string - convert Encore note type to the duration
+// written by the analysis ("/4" for a quarter note)
+//---------------------------------------------------------
+
+std::string faceValue2string(const quint8 faceValue)
+{
+    if (faceValue == 0 || faceValue >= FACEVALUE_COUNT)
+        return "???";
+
+    return std::string("/") + faceValue2denominator(faceValue);
+}
+
+
+//---------------------------------------------------------
+// correctFaceValue - correct note type to match actual duration
+// Common Encore bug: last note in measure has wrong duration
+// because m_durTicks is incorrect. Instead of changing duration
+// (which would overflow the measure), change the note type to match.
+// returns the face value of the corrected type, which is a valid
+// index in faceValueXmlTypes (0 for unknown face values)
+//---------------------------------------------------------
+
+// the durations with a known note type: plain, dotted and triplet (3:2 ratio,
+// so 2/3 of normal duration) and the face value giving that type
+static constexpr std::array<std::pair<int, quint8>, 19> durationFaceValues = {{
+    { 960, 1 }, { 480, 2 }, { 240, 3 }, { 120, 4 }, { 60, 5 }, { 30, 6 }, { 15, 7 },
+    { 720, 2 }, { 360, 3 }, { 180, 4 }, { 90, 5 }, { 45, 6 },
+    { 640, 1 }, { 320, 2 }, { 160, 3 }, { 80, 4 }, { 40, 5 }, { 20, 6 }, { 10, 7 }
+}};
+
+quint8 correctFaceValue(const int realDuration, const quint8 faceValue)
+{
+    // Get the type that faceValue would give
+    const quint8 originalType = (faceValue & 0x0F) < FACEVALUE_COUNT ? (faceValue & 0x0F) : 0;
+
+    if (realDuration <= 0) {
+        return originalType;
+    }
+
+    // Find what note type matches the actual duration
+    const auto it = std::find_if(durationFaceValues.cbegin(), durationFaceValues.cend(),
+                                 [realDuration](const std::pair<int, quint8>& dfv) { return dfv.first == realDuration; });
+    if (it == durationFaceValues.cend()) {
+        return originalType;
+    }
+
+    const quint8 correctType = it->second;
+    if (correctType != originalType) {
+        qDebug() << "xxx_type_fix: correcting type from" << faceValueXmlTypes[originalType]
+                 << "to" << faceValueXmlTypes[correctType] << "for duration" << realDuration;
+    }
+
+    return correctType;
+}
+
+
+//---------------------------------------------------------
+// Determine if note is a grace note
+//---------------------------------------------------------
+
+bool isGrace(const EncMeasureElemNote* const note)
+{
+    return note->graceType() != GraceType::NORMALNOTE;
+}
+
+
+//---------------------------------------------------------
+// calculateDuration - calculate duration from faceValue, dots, and tuplet info
+// Common logic shared by durationNote and durationRest
+//---------------------------------------------------------
+
+static int calculateDuration(const quint8 faceValue, const quint8 dotControl,
+                             const quint8 actualNotes, const quint8 normalNotes)
+{
+    int duration = faceValue2duration(faceValue & 0x0F);
+
+    // Apply dots (each dot adds half of previous value)
+    for (int i = 0; i < (dotControl & 3); ++i) {
+        duration *= 3;
+        duration /= 2;
+    }
+
+    // Apply time modification (tuplet)
+    if (actualNotes > 0 && normalNotes > 0) {
+        duration *= normalNotes;
+        duration /= actualNotes;
+    }
+
+    return duration;
+}
+
+
+//---------------------------------------------------------
+// durationNote - determine note's duration
+//---------------------------------------------------------
+
+// isStandardDuration - true iff d matches a known MusicXML note duration value.
+// Non-standard values (e.g. raw MIDI durations in live-recorded files) are excluded
+// so that face-value-based duration is used instead.
+static bool isStandardDuration(const int d)
+{
+    switch (d) {
+    // Plain note durations (whole..128th)
+    case 960: case 480: case 240: case 120: case 60: case 30: case 15: case 7:
+    // Single-dotted (base × 3/2)
+    case 720: case 360: case 180: case 90: case 45:
+    // Double-dotted (base × 7/4): 480×7/4=840, 240×7/4=420, 120×7/4=210, 60×7/4=105
+    case 840: case 420: case 210: case 105:
+    // Triple-dotted (base × 15/8): 480×15/8=900, 240×15/8=450, 120×15/8=225
+    case 900: case 450: case 225:
+    // Triplets (base × 2/3)
+    case 640: case 320: case 160: case 80: case 40: case 20:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int durationNote(const EncMeasureElemNote* const note)
+{
+    if (isGrace(note)) {
+        return 0;
+    }
+
+    // Use realDuration when it encodes a valid written duration:
+    // - a standard note length (plain, dotted, triplet), OR
+    // - a value that matches the face-value note under a recognised tuplet ratio.
+    // For live-recorded (MIDI-input) files the raw tick difference can be much
+    // larger than the written duration (e.g. 2564 in a 960-tick measure) and
+    // would overflow if used directly; those fall through to the face value.
+    if (note->m_realDuration > 0) {
+        if (isStandardDuration(note->m_realDuration))
+            return note->m_realDuration;
+        // Tuplet check: if detectTuplet recognises this as a rational tuplet of
+        // the face-value note, use realDuration (e.g. 48 = 16th × 4/5 quintuplet).
+        int dummy = 0;
+        if (detectTuplet(note->m_realDuration, note->m_faceValue, dummy) > 0)
+            return note->m_realDuration;
+    }
+
+    // Fall back to the plain face-value duration.
+    // The Encore dotControl byte is not reliably a dot count — the MuseScore
+    // importer ignores it and infers dots from realDuration instead.
+    // Applying dotControl here produces non-standard values (e.g. 135 from a
+    // 16th with dotControl=2) that make <duration> inconsistent with <type>.
+    return faceValue2duration(note->m_faceValue & 0x0F);
+}
+
+
+//---------------------------------------------------------
+// durationRest - determine rest's duration
+//---------------------------------------------------------
+
+int durationRest(const EncMeasureElemRest* const rest)
+{
+    // Compute the rest duration using the same approach as the MuseScore Encore
+    // importer: use face value for the base duration, then detect dots from the
+    // dotControl field (which stores the sounding duration in Encore ticks).
+    //
+    // We intentionally ignore m_tuplet: in MIDI-recorded Encore files the tuplet
+    // byte for rests is often noise (e.g. 11:6), and the old calculateDuration()
+    // path with raw actualNotes/normalNotes produced non-standard values like 49
+    // that crash MuseScore's MusicXML importer.
+    const int fv   = rest->m_faceValue & 0x0F;
+    const int base = faceValue2duration(fv);
+    if (base <= 0) return 0;
+
+    // Detect dot count from dotControl (visual sounding duration).
+    // dotControl == base     → 0 dots (plain)
+    // dotControl == base*3/2 → 1 dot  (dotted)
+    // dotControl == base*7/4 → 2 dots (double-dotted)
+    int dots = 0;
+    if (rest->m_dotControl > 0) {
+        const int dc = static_cast<int>(rest->m_dotControl);
+        if      (dc == base * 3 / 2) dots = 1;
+        else if (dc == base * 7 / 4) dots = 2;
+        else if (dc == base * 15 / 8) dots = 3;
+        // Non-standard value: fall through (dots = 0, plain face value)
+    }
+
+    // Apply dots using the correct formula (not iterative *3/2 which gives 9/4 for 2 dots):
+    // 0 dots: base, 1 dot: base*3/2, 2 dots: base*7/4, 3 dots: base*15/8
+    int result = base;
+    if      (dots == 1) result = base * 3 / 2;
+    else if (dots == 2) result = base * 7 / 4;
+    else if (dots == 3) result = base * 15 / 8;
+    return result;
+}
+
+
+//---------------------------------------------------------
+// isChordOf - determine if note2 is in a chord with a root at rootTick
+//---------------------------------------------------------
+
+// isChordOf - true iff note2's tick is within CHORD_MIDI_THRESHOLD of rootTick.
+bool isChordOf(const int rootTick, const EncMeasureElemNote* const note2)
+{
+    if (!note2 || rootTick < 0) return false;
+    const int delta = (int)note2->m_tick - rootTick;
+    return delta >= 0 && delta < CHORD_MIDI_THRESHOLD;
+}
+
+
+//---------------------------------------------------------
+// midipitch2xml
+//---------------------------------------------------------
+
+// determine pitch spelling based on pitch, accidental and key
+// (too) simple algorithm: fails e.g. for two b flats with same pitch in one measure:
+// - first (with accid) will be OK
+// - second (without accid) will not
+
+void midipitch2xml(const quint8 pitch, const accidentalType accid, const int fifths,
+                   char& step, int& alter, int& octave)
+{
+    // explicit flat, or need alter but no accid -> choose flat if fifths < 0
+    // all others none or sharp
+    const bool flat = accid == accidentalType::FLAT
+                      || (isAlteredPitch(pitch) && accid == accidentalType::NONE && fifths < 0);
+    const auto& spelling = flat ? flatSpellings[pitch] : sharpSpellings[pitch];
+    step   = spelling.m_step;
+    alter  = spelling.m_alter;
+    octave = spelling.m_octave;
+}
+
+// determine pitch spelling based on pitch only (always sharp), used by the analysis
+
+void midipitch2xml(const quint8 pitch, char& step, int& alter, int& octave)
+{
+    const auto& spelling = sharpSpellings[pitch];
+    step   = spelling.m_step;
+    alter  = spelling.m_alter;
+    octave = spelling.m_octave;
+}
+
+
+//---------------------------------------------------------
+// semiTonePitch2Lily - convert pitch to LilyPond note name and octave
+// (always flat), used by the text dump
+//---------------------------------------------------------
+
+QString semiTonePitch2Lily(const quint8 semiTonePitch)
+{
+    static constexpr const char* names[12] =
+        { "c", "des", "d", "es", "e", "f", "ges", "g", "aes", "a", "bes", "b" };
+    const int oct  = semiTonePitch / 12;
+
+    QString res = QString::fromLatin1(names[semiTonePitch % 12]);
+    if (oct > 4)
+        res += QString(oct - 4, '\'');
+    else if (oct < 4)
+        res += QString(4 - oct, ',');
+
+    return res;
+}
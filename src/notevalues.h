@@ -0,0 +1,135 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef NOTEVALUES_H
+#define NOTEVALUES_H
+
+#include <array>
+#include <string>
+
+#include <QString>
+
+#include "encfile.h"
+
+
+//---------------------------------------------------------
+// conversion of Encore note values (face value, duration,
+// dots and tuplets) to written durations and MusicXML types
+//---------------------------------------------------------
+
+// MIDI-recorded chords have simultaneous notes at ticks 0,1,2,... due to recording
+// latency. CHORD_MIDI_THRESHOLD defines the window for grouping them as a single chord.
+static constexpr int CHORD_MIDI_THRESHOLD = 2 * CHORD_CLUSTER_THRESHOLD;  // = 8
+
+
+//---------------------------------------------------------
+// tables indexed by Encore face value (1 = whole ... 8 = 128th),
+// shared by the MusicXML, text and analysis writers
+//---------------------------------------------------------
+
+static constexpr quint8 FACEVALUE_COUNT = 9;
+
+static constexpr std::array<int, FACEVALUE_COUNT> faceValueDurations =
+    { 0, 960, 480, 240, 120, 60, 30, 15, 7 };
+
+static constexpr std::array<const char*, FACEVALUE_COUNT> faceValueDenominators =
+    { "0", "1", "2", "4", "8", "16", "32", "64", "128" };
+
+static constexpr std::array<const char*, FACEVALUE_COUNT> faceValueXmlTypes =
+    { "???", "whole", "half", "quarter", "eighth", "16th", "32nd", "64th", "128th" };
+
+
+//---------------------------------------------------------
+// faceValue2duration - convert Encore note type to duration
+//---------------------------------------------------------
+
+/*
+ * note Encore uses:
+ * value 3 -> 240
+ * value 4 -> 120
+ */
+
+constexpr int faceValue2duration(const quint8 faceValue)
+{
+    return faceValue < FACEVALUE_COUNT ? faceValueDurations[faceValue] : 0;
+}
+
+
+//---------------------------------------------------------
+// faceValue2denominator - convert Encore note type to the
+// denominator of its duration ("4" for a quarter note)
+//---------------------------------------------------------
+
+constexpr const char* faceValue2denominator(const quint8 faceValue)
+{
+    return faceValue < FACEVALUE_COUNT ? faceValueDenominators[faceValue] : "???";
+}
+
+
+//---------------------------------------------------------
+// pitch spelling of all MIDI pitches, sharp and flat variant
+//---------------------------------------------------------
+
+struct PitchSpelling
+{
+    char    m_step      { 'C' };
+    int     m_alter     { 0 };
+    int     m_octave    { 0 };
+};
+
+using PitchSpellings = std::array<PitchSpelling, 256>;
+
+constexpr PitchSpellings makePitchSpellings(const bool flat)
+{
+    constexpr char noteTab[12] = { 'C', 'C', 'D', 'D', 'E', 'F', 'F', 'G', 'G', 'A', 'A', 'B' };
+    constexpr int alterTab[12] = { 0,   1,   0,   1,   0,  0,   1,   0,   1,   0,   1,   0 };
+    PitchSpellings res {};
+    for (int pitch = 0; pitch < static_cast<int>(res.size()); ++pitch) {
+        // 60 = C 4
+        if (flat)
+            res[pitch] = { noteTab[(pitch + 1) % 12], -1, (pitch + 1) / 12 - 1 };
+        else
+            res[pitch] = { noteTab[pitch % 12], alterTab[pitch % 12], pitch / 12 - 1 };
+    }
+    return res;
+}
+
+static constexpr PitchSpellings sharpSpellings = makePitchSpellings(false);
+static constexpr PitchSpellings flatSpellings = makePitchSpellings(true);
+
+constexpr bool isAlteredPitch(const quint8 pitch)
+{
+    return sharpSpellings[pitch].m_alter != 0;
+}
+
+void midipitch2xml(const quint8 pitch, const accidentalType accid, const int fifths, char& step, int& alter, int& octave);
+void midipitch2xml(const quint8 pitch, char& step, int& alter, int& octave);
+QString semiTonePitch2Lily(const quint8 semiTonePitch);
+
+int calculateDots(const int realDuration, const quint8 faceValue);
+int detectTuplet(const int realDuration, const quint8 faceValue, int& normalNotes);
+const QString& faceValue2xml(const quint8 faceValue);
+std::string faceValue2string(const quint8 faceValue);
+quint8 correctFaceValue(const int realDuration, const quint8 faceValue);
+bool isGrace(const EncMeasureElemNote* const note);
+int durationNote(const EncMeasureElemNote* const note);
+int durationRest(const EncMeasureElemRest* const rest);
+bool isChordOf(const int rootTick, const EncMeasureElemNote* const note2);
+
+#endif // NOTEVALUES_H
@@ -0,0 +1,11 @@
+# the Encore file parser, does not depend on Qt
+
+INCLUDEPATH += $$PWD
+DEPENDPATH  += $$PWD
+
+SOURCES += $$PWD/encfile.cpp \
+           $$PWD/encstream.cpp
+
+HEADERS += $$PWD/commondefs.h \
+           $$PWD/encfile.h \
+           $$PWD/encstream.h
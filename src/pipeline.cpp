@@ -0,0 +1,202 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <thread>
+
+#include <QElapsedTimer>
+#include <QtDebug>
+
+#include "encreader.h"
+#include "mxmlconverter.h"
+#include "pipeline.h"
+
+
+//---------------------------------------------------------
+// ConversionPipeline - constructor
+//---------------------------------------------------------
+
+ConversionPipeline::ConversionPipeline(const QStringList& filenames, const size_t prefetchWindow, const size_t queueCapacity)
+    : m_filenames(filenames), m_prefetchWindow(prefetchWindow),
+      m_loaded(prefetchWindow), m_parsed(queueCapacity), m_connected(queueCapacity)
+{
+
+}
+
+
+//---------------------------------------------------------
+// run - convert all files, returns when the last one has been written
+//---------------------------------------------------------
+
+void ConversionPipeline::run()
+{
+    std::thread loader(&ConversionPipeline::loadStage, this);
+    std::thread parser(&ConversionPipeline::parseStage, this);
+    std::thread connector(&ConversionPipeline::connectStage, this);
+    convertStage();
+    connector.join();
+    parser.join();
+    loader.join();
+
+    qDebug()
+        << "pipeline files" << m_filenames.size()
+        << "bytes read" << m_stats.m_bytesRead
+        << "read time (ms)" << m_stats.m_readTime
+        << "I/O wait time (ms)" << m_stats.m_ioWaitTime
+        ;
+}
+
+
+//---------------------------------------------------------
+// loadStage - read the raw contents of each file
+// the kernel is asked to read ahead the files that will be
+// needed once the prefetch window has room again
+//---------------------------------------------------------
+
+void ConversionPipeline::loadStage()
+{
+    const int count = static_cast<int>(m_filenames.size());
+    const int window = static_cast<int>(m_prefetchWindow);
+    for (int i = 0; i < count && i < window; ++i) {
+        adviseWillNeed(m_filenames.at(i));
+    }
+
+    QElapsedTimer timer;
+    for (int i = 0; i < count; ++i) {
+        if (i + window < count) {
+            adviseWillNeed(m_filenames.at(i + window));
+        }
+        PipelineItem item;
+        item.m_filename = m_filenames.at(i);
+        if (m_journal) {
+            item.m_fingerprint = ConversionJournal::fingerprint(item.m_filename);
+        }
+        timer.start();
+        item.m_error = loadEncFile(item.m_filename, item.m_data);
+        m_stats.m_readTime += timer.elapsed();
+        m_stats.m_bytesRead += item.m_data.size();
+        m_loaded.push(std::move(item));
+    }
+    m_loaded.close();
+}
+
+
+//---------------------------------------------------------
+// parseStage - parse each loaded file
+//---------------------------------------------------------
+
+void ConversionPipeline::parseStage()
+{
+    PipelineItem item;
+    QElapsedTimer timer;
+    timer.start();
+    while (m_loaded.pop(item)) {
+        m_stats.m_ioWaitTime += timer.elapsed();
+        item.m_ef.reset(new EncFile);
+        if (item.m_error.isEmpty()) {
+            item.m_error = readEncData(item.m_data, *item.m_ef);
+        }
+        item.m_data.clear();
+        m_parsed.push(std::move(item));
+        timer.start();
+    }
+    m_parsed.close();
+}
+
+
+//---------------------------------------------------------
+// connectStage - resolve the note connections of each parsed file
+//---------------------------------------------------------
+
+void ConversionPipeline::connectStage()
+{
+    PipelineItem item;
+    while (m_parsed.pop(item)) {
+        item.m_nc.reset(new NoteConnector(*item.m_ef));
+        m_connected.push(std::move(item));
+    }
+    m_connected.close();
+}
+
+
+//---------------------------------------------------------
+// convertStage - write the outputs of each connected file
+// nothing is written for a file that could not be read
+//---------------------------------------------------------
+
+void ConversionPipeline::convertStage()
+{
+    PipelineItem item;
+    while (m_connected.pop(item)) {
+        bool ok = item.m_error.isEmpty();
+        if (!ok) {
+            qWarning() << item.m_filename << item.m_error;
+        }
+        else if (m_writer) {
+            ok = m_writer(item);
+        }
+        if (!ok) {
+            ++m_stats.m_failedFiles;
+        }
+        if (m_journal) {
+            m_journal->record(item.m_filename, item.m_fingerprint, ok);
+        }
+    }
+}
+
+
+//---------------------------------------------------------
+// measureConverted - report when another tenth of the measures is done
+//---------------------------------------------------------
+
+void ProgressReporter::measureConverted(const ConversionProgress& progress)
+{
+    if (progress.m_measuresTotal == 0)
+        return;
+    const size_t tenth = 10 * progress.m_measuresDone / progress.m_measuresTotal;
+    if (tenth > m_lastTenth) {
+        m_lastTenth = tenth;
+        report(progress, "measure");
+    }
+}
+
+
+//---------------------------------------------------------
+// partConverted - report a completed part
+//---------------------------------------------------------
+
+void ProgressReporter::partConverted(const ConversionProgress& progress)
+{
+    report(progress, "part done");
+}
+
+
+//---------------------------------------------------------
+// report - write a single progress line
+//---------------------------------------------------------
+
+void ProgressReporter::report(const ConversionProgress& progress, const char* event)
+{
+    const size_t percent = progress.m_measuresTotal > 0 ? 100 * progress.m_measuresDone / progress.m_measuresTotal : 100;
+    qInfo().noquote()
+        << QString("%1: %2, part %3 of %4, measure %5 of %6, %7% (%8 ms)")
+           .arg(m_filename, event)
+           .arg(progress.m_partNr).arg(progress.m_partCount)
+           .arg(progress.m_measureNr + 1).arg(progress.m_measureCount)
+           .arg(percent).arg(progress.m_elapsed);
+}
@@ -0,0 +1,164 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <QStringList>
+
+#include "encfile.h"
+#include "journal.h"
+#include "mxmlconverter.h"
+#include "noteconnector.h"
+
+
+//---------------------------------------------------------
+// a fixed capacity FIFO connecting two pipeline stages
+// push() blocks while the queue is full, pop() while it is empty
+// after close() pop() drains the remaining items and then returns false
+//---------------------------------------------------------
+
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(const size_t capacity) : m_capacity(capacity > 0 ? capacity : 1) {}
+    void push(T&& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_items.size() < m_capacity; });
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+    }
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return !m_items.empty() || m_closed; });
+        if (m_items.empty())
+            return false;
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+    }
+private:
+    const size_t m_capacity;
+    std::deque<T> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    bool m_closed { false };
+};
+
+
+//---------------------------------------------------------
+// a single Encore file travelling through the pipeline
+//---------------------------------------------------------
+
+struct PipelineItem
+{
+    QString m_filename;
+    QString m_error;                        // empty if read successfully
+    QByteArray m_data;                      // raw file contents, released after parsing
+    std::unique_ptr<EncFile> m_ef;          // heap allocated: NoteConnector keeps a reference
+    std::unique_ptr<NoteConnector> m_nc;
+    JournalEntry m_fingerprint;             // taken before reading, only when recording in a journal
+};
+
+
+//---------------------------------------------------------
+// I/O statistics of a pipeline run (all times in milliseconds)
+//---------------------------------------------------------
+
+struct PipelineStats
+{
+    qint64 m_bytesRead      { 0 };
+    qint64 m_readTime       { 0 };  // time spent in the load stage reading files
+    qint64 m_ioWaitTime     { 0 };  // time the parse stage waited for file contents
+    int    m_failedFiles    { 0 };  // files that could not be read or written
+};
+
+
+//---------------------------------------------------------
+// the progress reporter writes the progress of converting
+// a single file to the log, after each part and after
+// each further tenth of the measures written
+//---------------------------------------------------------
+
+class ProgressReporter : public ConversionObserver
+{
+public:
+    explicit ProgressReporter(const QString& filename) : m_filename(filename) {}
+    void measureConverted(const ConversionProgress& progress) override;
+    void partConverted(const ConversionProgress& progress) override;
+private:
+    void report(const ConversionProgress& progress, const char* event);
+    const QString m_filename;
+    size_t m_lastTenth { 0 };
+};
+
+
+//---------------------------------------------------------
+// the conversion pipeline reads, parses and writes a list of Encore files
+// stage 0 (thread) reads up to prefetchWindow files ahead of the parser
+// stage 1 (thread) parses the files
+// stage 2 (thread) connects notes, slurs, ties and wedges
+// stage 3 (caller) passes each file read successfully to the writer,
+// which returns false if an output could not be written
+// files are written in input order
+// the outcome of each file is recorded in the journal (if not null)
+//---------------------------------------------------------
+
+class ConversionPipeline
+{
+public:
+    ConversionPipeline(const QStringList& filenames, const size_t prefetchWindow = 4, const size_t queueCapacity = 2);
+    using Writer = std::function<bool (PipelineItem& item)>;
+    void run();
+    void setWriter(const Writer& writer) { m_writer = writer; }
+    void setJournal(ConversionJournal* journal) { m_journal = journal; }
+    const PipelineStats& stats() const { return m_stats; }
+private:
+    void loadStage();
+    void parseStage();
+    void connectStage();
+    void convertStage();
+    const QStringList m_filenames;
+    const size_t m_prefetchWindow;
+    Writer m_writer;
+    ConversionJournal* m_journal { nullptr };
+    BoundedQueue<PipelineItem> m_loaded;
+    BoundedQueue<PipelineItem> m_parsed;
+    BoundedQueue<PipelineItem> m_connected;
+    PipelineStats m_stats;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,212 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <array>
+
+#include <QtDebug>
+
+#include "scoretimeline.h"
+
+
+//---------------------------------------------------------
+// Determine if measure measureNr is the first measure in an alternative ending
+//---------------------------------------------------------
+
+static bool isFirstMeasureInAltEnd(const MeasureVec& measures, const size_t measureNr)
+{
+    const auto repAlt = measures.at(measureNr).m_repeatAlternative;
+    if (repAlt == 0)
+        return false;
+
+    if (measureNr == 0)
+        return true;
+
+    if (measureNr > 0 && measures.at(measureNr - 1).m_repeatAlternative != repAlt)
+        return true;
+
+    return false;
+}
+
+
+//---------------------------------------------------------
+// Determine if measure measureNr is the last measure in an alternative ending
+//---------------------------------------------------------
+
+static bool isLastMeasureInAltEnd(const MeasureVec& measures, const size_t measureNr)
+{
+    const auto repAlt = measures.at(measureNr).m_repeatAlternative;
+    if (repAlt == 0)
+        return false;
+
+    if (measureNr == measures.size() - 1)
+        return true;
+
+    if (measureNr < measures.size() - 1 && measures.at(measureNr + 1).m_repeatAlternative != repAlt)
+        return true;
+
+    return false;
+}
+
+
+//---------------------------------------------------------
+// repeatAlternative2EndingNumber - convert repeatAlternative (one bit for each pass)
+// to MusicXML ending-number (a comma-separated list// of positive integers without leading zeros)
+//---------------------------------------------------------
+
+static QString repeatAlternative2EndingNumber(const quint8 repeatAlternative)
+{
+    const int max = 4;
+    int mask = 1;
+    QString res;
+    for (int i = 1; i <= max; ++i) {
+        if (repeatAlternative & mask) {
+            if (res.isEmpty())
+                res.setNum(i);
+            else
+                res += QString(", %1").arg(i);
+        }
+        mask <<= 1;
+    }
+    return res;
+}
+
+
+//---------------------------------------------------------
+// encRepeatToWords - convert Encore repeats to MusicXML words
+//---------------------------------------------------------
+
+static QString encRepeatToWords(const repeatType repeat)
+{
+    QString words;
+
+    if (repeat == repeatType::DS)
+        words = "D.S.";
+    else if (repeat == repeatType::DCALCODA)
+        words = "D.C. al Coda";
+    else if (repeat == repeatType::DCALFINE)
+        words = "D.C. al Fine";
+    else if (repeat == repeatType::DSALCODA)
+        words = "D.S. al Coda";
+    else if (repeat == repeatType::DSALFINE)
+        words = "D.S. al Fine";
+    else if (repeat == repeatType::DC)
+        words = "D.C.";
+    else if (repeat == repeatType::FINE)
+        words = "Fine";
+
+    return words;
+}
+
+
+// theoreticalDurTicks - the time-signature-correct measure duration in Encore ticks.
+// m_durTicks comes from the raw MIDI recording and can be off by a few ticks.
+// This computes what the measure *should* be from the written time signature.
+static int theoreticalDurTicks(const EncMeasure& m)
+{
+    if (m.m_timeSigNum == 0 || m.m_timeSigDen == 0)
+        return m.m_durTicks;
+    int beatTicks = 0;
+    switch (m.m_timeSigDen) {
+    case 1:  beatTicks = 960; break;
+    case 2:  beatTicks = 480; break;
+    case 4:  beatTicks = 240; break;
+    case 8:  beatTicks = 120; break;
+    case 16: beatTicks = 60;  break;
+    case 32: beatTicks = 30;  break;
+    case 64: beatTicks = 15;  break;
+    default: beatTicks = 240; break;
+    }
+    return m.m_timeSigNum * beatTicks;
+}
+
+
+//---------------------------------------------------------
+// encKeyToFifths - convert Encore key to MusicXML fifths
+//---------------------------------------------------------
+
+int encKeyToFifths(unsigned int key)
+{
+    static constexpr std::array<int, 15> v =
+        {
+            //   c   f  bf  ef  af  df  gf  cf  g   d   a   e   b  fs  cs
+            /**/ 0, -1, -2, -3, -4, -5, -6, -7, 1,  2,  3,  4,  5,  6,  7
+        };
+    if (key >= v.size()) {
+        qDebug() << "encKeyToFifths: key out of range:" << key;
+        return 0;
+    }
+    return v.at(key);
+}
+
+
+//---------------------------------------------------------
+// findKeyChange - find a key change in measure m
+//---------------------------------------------------------
+
+const EncMeasureElemKeyChange* findKeyChange(const EncMeasure& m)
+{
+    for (const auto elem : m.measureElems()) {
+        if (const EncMeasureElemKeyChange* const key = dynamic_cast<const EncMeasureElemKeyChange* const>(elem))
+            return key;
+    }
+    return nullptr;
+}
+
+
+//---------------------------------------------------------
+// ScoreTimeline - compute the measure information
+//---------------------------------------------------------
+
+/*
+ * The initial key is taken from the first staff of the first system.
+ * A key change in the first measure is ignored, as the initial attributes
+ * already contain the key. In later measures a key change becomes effective
+ * at the start of the measure and stays in effect until the next one.
+ */
+
+ScoreTimeline::ScoreTimeline(const EncFile& ef)
+{
+    const auto& measures = ef.measures();
+    m_measures.resize(measures.size());
+
+    int fifths = 0;
+    if (!measures.empty() && !ef.lines().empty() && !ef.lines().at(0).lineStaffData().empty()) {
+        fifths = encKeyToFifths(ef.lines().at(0).lineStaffData().at(0).m_key);
+    }
+
+    for (size_t i = 0; i < measures.size(); ++i) {
+        const auto& m = measures.at(i);
+        auto& info = m_measures.at(i);
+
+        if (i > 0) {
+            if (const auto keyCh = findKeyChange(m)) {
+                fifths = encKeyToFifths(keyCh->m_tipo);
+                info.m_keyChanged = true;
+            }
+            const auto& prevM = measures.at(i - 1);
+            info.m_timeSigChanged = m.m_timeSigNum != prevM.m_timeSigNum || m.m_timeSigDen != prevM.m_timeSigDen;
+        }
+        info.m_fifths = fifths;
+        info.m_endingStart = isFirstMeasureInAltEnd(measures, i);
+        info.m_endingStop = isLastMeasureInAltEnd(measures, i);
+        info.m_durTicks = theoreticalDurTicks(m);
+        info.m_endingNumber = repeatAlternative2EndingNumber(m.m_repeatAlternative);
+        info.m_repeatWords = encRepeatToWords(m.repeat());
+    }
+}
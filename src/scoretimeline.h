@@ -0,0 +1,71 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef SCORETIMELINE_H
+#define SCORETIMELINE_H
+
+#include <vector>
+
+#include <QString>
+
+#include "encfile.h"
+
+
+//---------------------------------------------------------
+// the score-level information of a single measure,
+// identical for all parts
+//---------------------------------------------------------
+
+struct MeasureInfo
+{
+    int     m_fifths            { 0 };      // key in effect for pitch spelling
+    bool    m_keyChanged        { false };  // key change at the start of this measure
+    bool    m_timeSigChanged    { false };  // time signature differs from previous measure
+    bool    m_endingStart       { false };  // first measure in an alternative ending
+    bool    m_endingStop        { false };  // last measure in an alternative ending
+    int     m_durTicks          { 0 };      // time-signature-correct duration
+    QString m_endingNumber;                 // MusicXML ending-number
+    QString m_repeatWords;                  // D.C., D.S., Fine etc.
+};
+
+
+//---------------------------------------------------------
+// the score timeline contains the measure information
+// for all measures, computed once for all parts
+//---------------------------------------------------------
+
+class ScoreTimeline
+{
+public:
+    ScoreTimeline(const EncFile& ef);
+    const MeasureInfo& at(const size_t measureNr) const { return m_measures.at(measureNr); }
+    size_t size() const { return m_measures.size(); }
+private:
+    std::vector<MeasureInfo> m_measures;
+};
+
+
+//---------------------------------------------------------
+// conversion helpers shared by the timeline and the converter
+//---------------------------------------------------------
+
+int encKeyToFifths(unsigned int key);
+const EncMeasureElemKeyChange* findKeyChange(const EncMeasure& m);
+
+#endif // SCORETIMELINE_H
@@ -9,22 +9,13 @@ TEMPLATE = app
 CONFIG  += console
 CONFIG  -= app_bundle
 
-SOURCES += analysisfile.cpp \
+include(app.pri)
+
+SOURCES += batchconverter.cpp \
            converter.cpp \
-           encfile.cpp \
-           main.cpp \
-           mxmlconverter.cpp \
-           mxmlwriter.cpp \
-           noteconnector.cpp \
-           textfile.cpp
+           main.cpp
 
-HEADERS += analysisfile.h \
-           converter.h \
-           commondefs.h \
-           encfile.h \
-           mxmlconverter.h \
-           mxmlwriter.h \
-           noteconnector.h \
-           textfile.h
+HEADERS += batchconverter.h \
+           converter.h
 
 RESOURCES += qml.qrc
@@ -17,13 +17,16 @@
 /*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
 /*****************************************************************************/
 
-#include <iostream>
-#include <iomanip>
-#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
 
 #include <QtDebug>
 
 #include "encfile.h"
+#include "encreader.h"
+#include "notevalues.h"
 #include "textfile.h"
 
 
@@ -178,53 +181,6 @@ const char * enc_lily_saltsigno (quint32 num)
     }
 }
 
-static QString semiTonePitch2Lily(const quint8 semiTonePitch)
-{
-    QString res;
-    const int note = semiTonePitch % 12;
-    const int oct  = semiTonePitch / 12;
-
-    switch (note)
-    {
-    case  0: res = "c"; break;
-    case  1: res = "des"; break;
-    case  2: res = "d"; break;
-    case  3: res = "es"; break;
-    case  4: res = "e"; break;
-    case  5: res = "f"; break;
-    case  6: res = "ges"; break;
-    case  7: res = "g"; break;
-    case  8: res = "aes"; break;
-    case  9: res = "a"; break;
-    case 10: res = "bes"; break;
-    case 11: res = "b"; break;
-    }
-
-    for (int i = oct; i > 4; i--)
-        res += "'";
-
-    for (int i = oct; i < 4; ++i)
-        res += ",";
-
-    return res;
-}
-
-static QString faceValue2Lily(const quint8 faceValue)
-{
-    switch (faceValue) {
-    case 0: return "0";
-    case 1: return "1";
-    case 2: return "2";
-    case 3: return "4";
-    case 4: return "8";
-    case 5: return "16";
-    case 6: return "32";
-    case 7: return "64";
-    case 8: return "128";
-    }
-    return "???";
-}
-
 const char * enc_lily_punkto (quint8 punkto)
 {
     const char *chenoj[] = {"", ".", "..", "..."};
@@ -645,7 +601,7 @@ const char * enc_lily_akordo (const EncMeasureElemChord* const chord, unsigned c
 
     if (chord->m_tipo == 0x11)
     {
-        bufro[0] = chord->m_teksto.toLower().toLatin1().at(0);
+        bufro[0] = toQString(chord->m_teksto).toLower().toLatin1().at(0);
         bufro[1] = 0;
         if (rapido < 9)
             strcat (bufro, enc_lily_rapido (rapido));
@@ -663,7 +619,7 @@ const char * enc_lily_akordo (const EncMeasureElemChord* const chord, unsigned c
             strcat (bufro, enc_lily_rapido (rapido));
 
         if (chord->m_tipo & 0x01)
-            sprintf (ero, ":%s", chord->m_teksto.toLatin1().data());
+            sprintf (ero, ":%s", toQString(chord->m_teksto).toLatin1().data());
         else if (chord->m_toniko)
             sprintf (ero, ":%s", tnk[chord->m_toniko]);
         else
@@ -684,14 +640,88 @@ const char * enc_lily_akordo (const EncMeasureElemChord* const chord, unsigned c
 }
 
 
+//---------------------------------------------------------
+// TextBuffer - constructor
+//---------------------------------------------------------
+
+TextBuffer::TextBuffer(QIODevice* device, const int chunkSize)
+    : m_device(device), m_chunkSize(chunkSize)
+{
+    m_buffer.reserve(chunkSize + 1024);
+}
+
+
+//---------------------------------------------------------
+// operator<< - append a string, a character or a number
+//---------------------------------------------------------
+
+TextBuffer& TextBuffer::operator<<(const char* s)
+{
+    m_buffer.append(s, static_cast<qsizetype>(strlen(s)));
+    flushIfFull();
+    return *this;
+}
+
+TextBuffer& TextBuffer::operator<<(const char c)
+{
+    m_buffer.append(c);
+    flushIfFull();
+    return *this;
+}
+
+TextBuffer& TextBuffer::operator<<(const QString& s)
+{
+    m_buffer.append(s.toLocal8Bit());
+    flushIfFull();
+    return *this;
+}
+
+// formatted as std::ostream does: right aligned, lower case hex digits,
+// the sign counts toward the width
+
+TextBuffer& TextBuffer::operator<<(const TextField& f)
+{
+    char digits[24];
+    int pos = sizeof(digits);
+    auto value = f.m_value;
+    do {
+        const int d = static_cast<int>(value % f.m_base);
+        digits[--pos] = static_cast<char>(d < 10 ? '0' + d : 'a' + d - 10);
+        value /= f.m_base;
+    } while (value);
+    if (f.m_negative)
+        digits[--pos] = '-';
+    const int len = static_cast<int>(sizeof(digits)) - pos;
+    for (int i = len; i < f.m_width; ++i)
+        m_buffer.append(f.m_fill);
+    m_buffer.append(digits + pos, len);
+    flushIfFull();
+    return *this;
+}
+
+
+//---------------------------------------------------------
+// flush - write the buffered text to the device
+//---------------------------------------------------------
+
+void TextBuffer::flush()
+{
+    if (m_buffer.isEmpty())
+        return;
+    if (m_device)
+        m_device->write(m_buffer.constData(), m_buffer.size());
+    m_buffer.clear();
+}
+
+
 //---------------------------------------------------------
 // TextFile - write analysis result
 // result is (besides minor formatting differences)
 // identical to enc2ly 0.6 output
 //---------------------------------------------------------
 
-TextFile::TextFile(const EncFile& ef)
-    : m_ef(ef)
+TextFile::TextFile(const EncFile& ef, QIODevice* device)
+    : m_ef(ef), m_out(device)
 {
 
 }
@@ -708,26 +738,25 @@ void TextFile::write()
     writeInstruments();
     writeLines();
     writeMeasures();
+    m_out.flush();
 }
 
 
 void TextFile::writeHeader()
 {
     const EncHeader& hdr = m_ef.header();
-    std::cout
+    m_out
         << "---- KAPO ----" << "\n"
-        << std::hex
-        << "Magio      : " << qPrintable(hdr.m_magic) << "\n"
-        << "Chu_magio  : " << std::setw(4) << static_cast<unsigned int>(hdr.m_chuMagio) << "\n"
-        << "Chu_versio : " << std::setw(4) << hdr.m_chuVersio << "\n"
-        << "Nekonata1  : " << std::setw(4) << hdr.m_nekon1 << "\n"
-        << "Fiksa1     : " << std::setw(4) << hdr.m_fiksa1 << "\n"
-        << std::dec
-        << "N sistemoj : " << std::setw(4) << hdr.m_lineCount << "\n"
-        << "N paghoj   : " << std::setw(4) << hdr.m_pageCount << "\n"
-        << "N1 liniaroj: " << std::setw(4) << static_cast<int>(hdr.m_instrumentCount) << "\n"
-        << "N2 liniaroj: " << std::setw(4) << static_cast<int>(hdr.m_staffPerSystem) << "\n"
-        << "N mezuroj  : " << std::setw(4) << hdr.m_measureCount << "\n"
+        << "Magio      : " << toQString(hdr.m_magic) << "\n"
+        << "Chu_magio  : " << hex(static_cast<unsigned int>(hdr.m_chuMagio), 4) << "\n"
+        << "Chu_versio : " << hex(hdr.m_chuVersio, 4) << "\n"
+        << "Nekonata1  : " << hex(hdr.m_nekon1, 4) << "\n"
+        << "Fiksa1     : " << hex(hdr.m_fiksa1, 4) << "\n"
+        << "N sistemoj : " << dec(hdr.m_lineCount, 4) << "\n"
+        << "N paghoj   : " << dec(hdr.m_pageCount, 4) << "\n"
+        << "N1 liniaroj: " << dec(static_cast<int>(hdr.m_instrumentCount), 4) << "\n"
+        << "N2 liniaroj: " << dec(static_cast<int>(hdr.m_staffPerSystem), 4) << "\n"
+        << "N mezuroj  : " << dec(hdr.m_measureCount, 4) << "\n"
         << "\n";
 }
 
@@ -735,23 +764,23 @@ void TextFile::writeHeader()
 void TextFile::writeTitle()
 {
     const EncTitle& ttl = m_ef.title();
-    std::cout
+    m_out
         << "---- TITOLOJ ----" << "\n"
         << "-->  Grando: " << ttl.m_varsize << " B" << "\n"
-        << "  Titolo      : " << qPrintable(ttl.m_title) << "\n";
+        << "  Titolo      : " << toQString(ttl.m_title) << "\n";
     for (int i = 0; i < 2 && ttl.m_subtitle.size(); ++i)
-        std::cout << "  Subtitolo " << i <<" : " << qPrintable(ttl.m_subtitle.at(i)) << "\n";
+        m_out << "  Subtitolo " << i <<" : " << toQString(ttl.m_subtitle.at(i)) << "\n";
     for (int i = 0; i < 3 && ttl.m_instruction.size(); ++i)
-        std::cout << "  Instrukcio " << i <<": " << qPrintable(ttl.m_instruction.at(i)) << "\n";
+        m_out << "  Instrukcio " << i <<": " << toQString(ttl.m_instruction.at(i)) << "\n";
     for (int i = 0; i < 4 && ttl.m_author.size(); ++i)
-        std::cout << "  Autoro " << i <<"    : " << qPrintable(ttl.m_author.at(i)) << "\n";
+        m_out << "  Autoro " << i <<"    : " << toQString(ttl.m_author.at(i)) << "\n";
     for (int i = 0; i < 2 && ttl.m_header.size(); ++i)
-        std::cout << "  Kapo " << i <<"      : " << qPrintable(ttl.m_header.at(i)) << "\n";
+        m_out << "  Kapo " << i <<"      : " << toQString(ttl.m_header.at(i)) << "\n";
     for (int i = 0; i < 2 && ttl.m_footer.size(); ++i)
-        std::cout << "  Piedo " << i <<"     : " << qPrintable(ttl.m_footer.at(i)) << "\n";
+        m_out << "  Piedo " << i <<"     : " << toQString(ttl.m_footer.at(i)) << "\n";
     for (int i = 0; i < 6 && ttl.m_copyright.size(); ++i)
-        std::cout << "  Kopirajto " << i <<" : " << qPrintable(ttl.m_copyright.at(i)) << "\n";
-    std::cout
+        m_out << "  Kopirajto " << i <<" : " << toQString(ttl.m_copyright.at(i)) << "\n";
+    m_out
         << "\n";
 }
 
@@ -759,46 +788,46 @@ void TextFile::writeTitle()
 void TextFile::writeText()
 {
     const EncText& txt = m_ef.text();
-    std::cout
+    m_out
         << "---- TEKSTOJ ----" << "\n"
         << "  --> Kiom: " << txt.m_texts.size() << "\n";
     for (unsigned int i = 0; i < txt.m_texts.size(); ++i)
-        std::cout << "  Teksto " << i << " : " << qPrintable(txt.m_texts.at(i)) << "\n";
-    std::cout
+        m_out << "  Teksto " << i << " : " << toQString(txt.m_texts.at(i)) << "\n";
+    m_out
         << "\n";
 }
 
 
 void TextFile::writeInstruments()
 {
-    std::cout
+    m_out
         << "---- INSTRUMENTOJ ----" << "\n";
     int count = 0;
     for (const auto& s : m_ef.staves()) {
         ++count;
-        std::cout
-            << "\t" << std::setw(2) << std::setfill('0') << count << ": " << qPrintable(s.m_name) << "\n";
+        m_out
+            << "\t" << dec(count, 2, '0') << ": " << toQString(s.m_name) << "\n";
     }
-    std::cout
+    m_out
         << "\n";
 }
 
 
 void TextFile::writeLines()
 {
-    std::cout
+    m_out
         << "---- LINIOJ ----" << "\n";
     int count = 0;
     for (const auto& l : m_ef.lines()) {
         ++count;
-        std::cout
-            << "  ---> Linio " << std::setw(2) << std::setfill('0') << count << "\n"
-            << "\tTipo   : 0x" << std::hex << std::setw(2) << (l.m_offset & 0xFF) << "\n"
-            << "\tMezuroj: " << std::dec << static_cast<int>(l.m_measureCount) << "\n"
+        m_out
+            << "  ---> Linio " << dec(count, 2, '0') << "\n"
+            << "\tTipo   : 0x" << hex(l.m_offset & 0xFF, 2, '0') << "\n"
+            << "\tMezuroj: " << static_cast<int>(l.m_measureCount) << "\n"
             ;
         writeLineStaffData(l);
     }
-    std::cout
+    m_out
         << "\n";
 }
 
@@ -807,7 +836,7 @@ void TextFile::writeLineStaffData(const EncLine& line)
 {
     int count = 0;
     for (const auto& d : line.lineStaffData()) {
-        std::cout
+        m_out
             << "\t---> Liniaro: "  << count << "\n"
             << "\t\tTipo  : " << enc_lily_liniaro(/* TODO */ static_cast<quint8>(d.m_staffType)) << "\n"
             << "\t\tKlefo : " << enc_lily_klefo(/* TODO */ static_cast<qint8>(d.m_clef)) << "\n"
@@ -820,30 +849,34 @@ void TextFile::writeLineStaffData(const EncLine& line)
 
 void TextFile::writeMeasures()
 {
-    std::cout
+    m_out
         << "---- MEZUROJ ----" << "\n";
     int count = 0;
     for (const auto& m : m_ef.measures()) {
         ++count;
-        std::cout
+        m_out
             << "---> Mezuro "   << count << "\n"
             << "\tGrando    : " << m.m_varsize << " B" << "\n"
             << "\tRapido    : " << m.m_bpm << " FPM" << "\n"
             << "\tTakto     : " << static_cast<int>(m.m_timeSigNum) << "/" << static_cast<int>(m.m_timeSigDen) << "\n"
             << "\tStangoj   : " << enc_lily_stango(m.m_barTypeStart) << enc_lily_stango(m.m_barTypeEnd) << "\n"
-            << "\tRipetsalto: 0x" << std::hex << static_cast<int>(m.m_repeatAlternative) << std::dec << "\n"
+            << "\tRipetsalto: 0x" << hex(static_cast<unsigned int>(m.m_repeatAlternative)) << "\n"
             << "\tSaltsigno : " << enc_lily_saltsigno((m.m_coda >> 8) & 0xFF) << "\n"
             << " Objektoj (en liniaroj):"<< "\n"
             ;
+        // sort the elements once by staff and xoffset, keeping elements
+        // with the same staff and xoffset in file order
+        auto& elems = m_sortedElems;
+        elems.assign(m.measureElems().cbegin(), m.measureElems().cend());
+        std::stable_sort(elems.begin(), elems.end(),
+                         [](const EncMeasureElem* const e1, const EncMeasureElem* const e2) {
+                             return std::make_pair(e1->m_staffIdx, e1->m_xoffset) < std::make_pair(e2->m_staffIdx, e2->m_xoffset);
+                         });
+        auto it = elems.cbegin();
         for (int i = 0; i < m_ef.header().m_staffPerSystem; ++i) {
-            std::multimap<quint8 , const EncMeasureElem* const> mmap;
-            for (const auto e : m.measureElems()) {
-                if (i == e->m_staffIdx)
-                    mmap.insert({e->m_xoffset, e});
-            }
-            for (const auto& e : mmap)
-                writeMeasureElem(e.second);
-            std::cout << "--------------\n";
+            for (; it != elems.cend() && (*it)->m_staffIdx == i; ++it)
+                writeMeasureElem(*it);
+            m_out << "--------------\n";
         }
     }
 }
@@ -863,11 +896,11 @@ void TextFile::writeMeasureElem(const EncMeasureElem* const elem)
             adorno = note->articulationUp();
         else if (note->m_dotControl & 0x40)
             adorno = note->articulationDown();
-        std::cout
+        m_out
             << " "
             << (isPercClef ? enc_lily_vpoz_frape (note->m_position)
-                           : (isRhythmStaff ? "c" : qPrintable(semiTonePitch2Lily(note->m_semiTonePitch))))
-            << qPrintable(faceValue2Lily(note->m_faceValue & 0x0F))
+                           : (isRhythmStaff ? "c" : semiTonePitch2Lily(note->m_semiTonePitch)))
+            << faceValue2denominator(note->m_faceValue & 0x0F)
             << ((note->m_grace1 & 0x30) > 0x10 ? "!" : "")
             << enc_lily_punkto(note->m_dotControl & 3)
             << enc_lily_opeco(note->m_tuplet)
@@ -877,14 +910,14 @@ void TextFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemClef* const clef = dynamic_cast<const EncMeasureElemClef* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << "Clef (TODO)"
             << " (vocho: " << static_cast<int>(clef->m_voice) << ")"
             << "\n";
     }
     else if (const EncMeasureElemOrnament* const orna = dynamic_cast<const EncMeasureElemOrnament* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << enc_lily_simbolo(static_cast<quint8>(orna->type()), orna->m_speguleco)
             << " [0;" << static_cast<int>(orna->m_xoffset)
@@ -895,14 +928,14 @@ void TextFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemLyric* const lyric = dynamic_cast<const EncMeasureElemLyric* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << "Lyric (TODO)"
             << " (vocho: " << static_cast<int>(lyric->m_voice) << ")"
             << "\n";
     }
     else if (const EncMeasureElemTie* const tie = dynamic_cast<const EncMeasureElemTie* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << "~"
             << " [" << static_cast<int>(tie->m_xoffset) << "]"
@@ -910,7 +943,7 @@ void TextFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemBeam* const beam = dynamic_cast<const EncMeasureElemBeam* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << "Vostligo"
             << " [" << static_cast<int>(beam->m_xoffset) << "]"
@@ -918,16 +951,16 @@ void TextFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemRest* const rest = dynamic_cast<const EncMeasureElemRest* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << "r"
-            << qPrintable(faceValue2Lily(rest->m_faceValue & 0x0F))
+            << faceValue2denominator(rest->m_faceValue & 0x0F)
             << " [" << static_cast<int>(rest->m_xoffset) << "]"
             << " (vocho: " << static_cast<int>(rest->m_voice) << ")"
             << "\n";
     }
     else if (const EncMeasureElemChord* const chord = dynamic_cast<const EncMeasureElemChord* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << "^\""
             << enc_lily_akordo(chord, -1)
@@ -937,7 +970,7 @@ void TextFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemKeyChange* const key = dynamic_cast<const EncMeasureElemKeyChange* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << "\\key "
             << enc_lily_tonalo(key->m_tipo)
@@ -946,7 +979,7 @@ void TextFile::writeMeasureElem(const EncMeasureElem* const elem)
             << "\n";
     }
     else if (const EncMeasureElemUnknown* const unknown = dynamic_cast<const EncMeasureElemUnknown* const>(elem)) {
-        std::cout
+        m_out
             << " "
             << "Unknown (TODO)"
             << " (vocho: " << static_cast<int>(unknown->m_voice) << ")"
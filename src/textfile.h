@@ -20,9 +20,72 @@
 #ifndef TEXTFILE_H
 #define TEXTFILE_H
 
+#include <type_traits>
+#include <vector>
+
+#include <QByteArray>
+#include <QIODevice>
+
 #include "encfile.h"
 
 
+//---------------------------------------------------------
+// a number to be formatted with a given base, width and fill
+//---------------------------------------------------------
+
+struct TextField
+{
+    unsigned long long m_value { 0 };
+    bool    m_negative  { false };
+    int     m_base      { 10 };
+    int     m_width     { 0 };
+    char    m_fill      { ' ' };
+};
+
+template <typename T>
+TextField dec(const T value, const int width = 0, const char fill = ' ')
+{
+    static_assert(std::is_integral<T>::value, "integral type required");
+    if constexpr (std::is_signed<T>::value) {
+        if (value < 0)
+            return { 0ULL - static_cast<unsigned long long>(value), true, 10, width, fill };
+    }
+    return { static_cast<unsigned long long>(value), false, 10, width, fill };
+}
+
+template <typename T>
+TextField hex(const T value, const int width = 0, const char fill = ' ')
+{
+    static_assert(std::is_unsigned<T>::value, "unsigned type required");
+    return { static_cast<unsigned long long>(value), false, 16, width, fill };
+}
+
+
+//---------------------------------------------------------
+// the text buffer collects formatted text and writes it
+// to its device in large chunks
+//---------------------------------------------------------
+
+class TextBuffer
+{
+public:
+    explicit TextBuffer(QIODevice* device, const int chunkSize = 64 * 1024);
+    ~TextBuffer() { flush(); }
+    TextBuffer& operator<<(const char* s);
+    TextBuffer& operator<<(const char c);
+    TextBuffer& operator<<(const QString& s);
+    TextBuffer& operator<<(const TextField& f);
+    template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+    TextBuffer& operator<<(const T n) { return *this << dec(n); }
+    void flush();
+private:
+    void flushIfFull() { if (m_buffer.size() >= m_chunkSize) flush(); }
+    QIODevice* m_device;
+    const int m_chunkSize;
+    QByteArray m_buffer;
+};
+
+
 //---------------------------------------------------------
 // the analysis file writer
 //---------------------------------------------------------
@@ -30,7 +93,7 @@
 class TextFile
 {
 public:
-    TextFile(const EncFile& ef);
+    TextFile(const EncFile& ef, QIODevice* device);
     void write();
 private:
     void writeHeader();
@@ -42,6 +105,8 @@ private:
     void writeMeasures();
     void writeMeasureElem(const EncMeasureElem* const elem);
     const EncFile& m_ef;
+    TextBuffer m_out;
+    std::vector<const EncMeasureElem*> m_sortedElems;  // scratch buffer for writeMeasures()
 };
 
 #endif // TEXTFILE_H
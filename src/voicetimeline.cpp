@@ -0,0 +1,416 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#include <algorithm>
+#include <climits>
+
+#include <QtDebug>
+
+#include "notevalues.h"
+#include "voicetimeline.h"
+
+
+//---------------------------------------------------------
+// TupletHandler - handle tuplet state
+// Groups tuplets by their natural duration - all tuplet notes within the same
+// tuplet group belong together. The group duration depends on note value:
+// - Eighth triplet (80 ticks each): group = 240 ticks (one quarter beat)
+// - Quarter triplet (160 ticks each): group = 480 ticks (one half beat)
+// - Sixteenth triplet (40 ticks each): group = 120 ticks (one eighth beat)
+//---------------------------------------------------------
+
+TupletState TupletHandler::newNote(const quint8 actualNotes, const quint8 normalNotes, const int tick, const int duration)
+{
+    TupletState res { TupletState::NONE };
+
+    if (actualNotes <= 0 || normalNotes <= 0) {
+        // Not a tuplet note
+        if (m_inTuplet) {
+            // End previous tuplet group
+            res = TupletState::STOP;
+            m_inTuplet = false;
+            m_groupStartTick = -1;
+            m_groupDuration = 0;
+        }
+        return res;
+    }
+
+    // Calculate the total duration of this tuplet group
+    // For 3:2, three notes replace two normal notes, so group = duration * actualNotes
+    int groupDuration = duration * actualNotes;
+
+    if (!m_inTuplet) {
+        // Start a new tuplet group
+        res = TupletState::START;
+        m_inTuplet = true;
+        m_groupStartTick = tick;
+        m_groupDuration = groupDuration;
+    }
+    else {
+        // Check if this note belongs to a different tuplet group
+        // A new group starts only if we've exceeded the current group's duration
+        // Don't start new group just because note value changed (allows mixed eighths/sixteenths)
+        if (tick >= m_groupStartTick + m_groupDuration) {
+            // Close previous tuplet and start new one
+            res = TupletState::STOPSTART;
+            m_groupStartTick = tick;
+            m_groupDuration = groupDuration;
+        }
+    }
+    // else: continue in same tuplet group (no action needed)
+
+    return res;
+}
+
+
+//---------------------------------------------------------
+// VoiceLookahead
+//---------------------------------------------------------
+
+/*
+ * For a note at tick t the next non-chord element is the first following
+ * element that is a rest or a note with a tick outside [t, t + CHORD_MIDI_THRESHOLD).
+ * For a rest it is simply the following element.
+ *
+ * A single backward pass keeps two monotonic stacks of the elements after
+ * the current one: the prefix minima and the prefix maxima of their ticks
+ * (rests count as minus infinity). The first element below t resp. at or
+ * above t + CHORD_MIDI_THRESHOLD is found by binary search on these stacks,
+ * replacing the forward scan per element.
+ */
+
+void VoiceLookahead::init(const std::vector<const EncMeasureElem*>& elems, const std::vector<int>& durations)
+{
+    const int n = static_cast<int>(elems.size());
+    m_next.assign(n, -1);
+    m_isTuplet.assign(n, 0);
+    m_keys.resize(n);
+    m_lowStack.clear();
+    m_highStack.clear();
+
+    // tuplet status, using the same detection as note() and rest(): check stored
+    // actualNotes first, then detectTuplet (for MIDI-recorded files where actual/normal == 0)
+    for (int i = 0; i < n; ++i) {
+        int actual = 0;
+        int dummy = 0;
+        if (const auto* note = dynamic_cast<const EncMeasureElemNote*>(elems[i])) {
+            m_keys[i] = note->m_tick;
+            actual = note->actualNotes();
+            if (actual == 0)
+                actual = detectTuplet(durations[i], note->m_faceValue, dummy);
+        }
+        else if (const auto* rest = dynamic_cast<const EncMeasureElemRest*>(elems[i])) {
+            m_keys[i] = INT_MIN;
+            actual = rest->actualNotes();
+            if (actual == 0)
+                actual = detectTuplet(durations[i], rest->m_faceValue, dummy);
+        }
+        m_isTuplet[i] = actual > 0;
+    }
+
+    for (int i = n - 1; i >= 0; --i) {
+        if (m_keys[i] == INT_MIN) {
+            m_next[i] = (i + 1 < n) ? i + 1 : -1;
+        }
+        else {
+            // stacks hold element indices, top (back) is nearest, keys strictly
+            // increasing (low stack) resp. decreasing (high stack) towards the top
+            const int low = m_keys[i];
+            const int high = m_keys[i] + CHORD_MIDI_THRESHOLD;
+            const auto itLow = std::lower_bound(m_lowStack.cbegin(), m_lowStack.cend(), low,
+                                                [this](const int idx, const int x) { return m_keys[idx] < x; });
+            const auto itHigh = std::lower_bound(m_highStack.cbegin(), m_highStack.cend(), high,
+                                                 [this](const int idx, const int x) { return m_keys[idx] >= x; });
+            int next = -1;
+            if (itLow != m_lowStack.cbegin())
+                next = *(itLow - 1);
+            if (itHigh != m_highStack.cbegin() && (next < 0 || *(itHigh - 1) < next))
+                next = *(itHigh - 1);
+            m_next[i] = next;
+        }
+
+        while (!m_lowStack.empty() && m_keys[m_lowStack.back()] >= m_keys[i])
+            m_lowStack.pop_back();
+        m_lowStack.push_back(i);
+        while (!m_highStack.empty() && m_keys[m_highStack.back()] <= m_keys[i])
+            m_highStack.pop_back();
+        m_highStack.push_back(i);
+    }
+}
+
+
+//---------------------------------------------------------
+// VoiceTimeline - compute the voice events
+//---------------------------------------------------------
+
+/*
+ * As elem->m_tick sometimes differs slightly from the expected value, simply
+ * assume all voices start at tick = 0 and no gaps are present. Written ticks
+ * are accumulated from written durations, elem->m_tick is only used for chord
+ * detection.
+ */
+
+VoiceTimeline::VoiceTimeline(const EncFile& ef, const NoteConnector& nc, const ScoreTimeline& timeline)
+    : m_ef(ef), m_nc(nc), m_timeline(timeline)
+{
+
+}
+
+
+//---------------------------------------------------------
+// initStaff - compute the voice events of staff staffIdx in measure m
+//---------------------------------------------------------
+
+void VoiceTimeline::initStaff(const EncMeasure& m, const quint8 staffIdx, const int measureDur)
+{
+    // sorted, unique voices in this staff
+    auto& voiceNrs = m_voiceNrs;
+    voiceNrs.clear();
+    for (const auto e : m.measureElems()) {
+        if (e->m_staffIdx == staffIdx)
+            voiceNrs.push_back(e->m_voice);
+    }
+    std::sort(voiceNrs.begin(), voiceNrs.end());
+    voiceNrs.erase(std::unique(voiceNrs.begin(), voiceNrs.end()), voiceNrs.end());
+
+    // Tracks filtered MIDI artifact tie-senders across all voices in this measure.
+    // A note with (grace1 & 0x0F) == 1 filtered by rdur<15 implies its receiver
+    // (grace1 & 0x0F == 2, same staff/voice/pitch) should also be filtered.
+    auto& filteredTieSenderPitches = m_filteredTieSenderPitches;
+    filteredTieSenderPitches.clear();
+
+    auto& staffVoices = m_voices;
+    staffVoices.clear();
+    m_events.clear();
+
+    for (const auto v : voiceNrs) {
+        staffVoices.emplace_back();
+        auto& ve = staffVoices.back();
+        ve.m_voice = v;
+        ve.m_first = m_events.size();
+
+        // chordRootTick tracks the tick of the last chord-root note (updated only
+        // for non-chord notes — no cascading).
+        // Used for chord detection: a note is a chord extension if its tick is within
+        // CHORD_MIDI_THRESHOLD of chordRootTick. This avoids cascading (chain detection)
+        // and handles MIDI-recorded chords where simultaneous notes land at ticks 0,1,2,...
+        int chordRootTick = -999;
+        int tick = 0;
+
+        // First pass: collect valid elements, applying MIDI artifact filter.
+        // The filter skips notes with realDuration < 15 that Encore records as
+        // MIDI ghost notes (not displayed in the score).
+        // The written duration of each element is computed once and kept in voiceDurs.
+        auto& voiceElems = m_voiceElems;
+        auto& voiceDurs = m_voiceDurs;
+        voiceElems.clear();
+        voiceDurs.clear();
+        for (const auto elem : m.measureElems()) {
+            if (elem->m_staffIdx != staffIdx || elem->m_voice != v)
+                continue;
+            if (elem->m_tick > measureDur) continue;  // Skip garbage
+            if (const auto* note = dynamic_cast<const EncMeasureElemNote*>(elem)) {
+                const int noteDur = durationNote(note);
+                // isChord: is this note a chord extension of the current chord root?
+                // Uses CHORD_MIDI_THRESHOLD so MIDI-recorded chords (notes at ticks
+                // 0,1,2,3...) are grouped correctly without overflowing the measure.
+                const bool isChord = isChordOf(chordRootTick, note);
+                if (!isChord) {
+                    // Skip if the measure is already full, OR if this note's written
+                    // duration would overflow it.  The second check prevents a single
+                    // long-realDuration note (e.g. a MIDI-recorded dotted half at
+                    // beat 3 of a 4/4 bar) from pushing tick past m_durTicks.
+                    if (tick >= measureDur || tick + noteDur > measureDur)
+                        continue;
+                }
+
+                // Update chordRootTick before filter checks (as MuseScore does with
+                // prevMidiTick): even filtered notes establish the root for subsequent
+                // chord-extension detection.
+                if (!isChord)
+                    chordRootTick = (int)note->m_tick;
+
+                // MIDI artifact filter
+                if (note->m_realDuration > 0 && note->m_realDuration < 15) {
+                    const quint8 fv = note->m_faceValue & 0x0F;
+                    const int fvBase = faceValue2duration(fv);
+                    if (fvBase <= 15) {
+                        // 64th/128th notes: filter unless tie-start or chord extension
+                        if (!m_nc.tieStart(note) && !isChord) {
+                            if ((note->m_grace1 & 0x0F) == 1)
+                                filteredTieSenderPitches.emplace_back(v, note->m_semiTonePitch);
+                            continue;
+                        }
+                    } else {
+                        // Longer face values: filter unless at the chord-cluster boundary
+                        // (realDuration <= CHORD_CLUSTER_THRESHOLD means it may be a
+                        // live-recorded chord root whose cluster partner fell just outside)
+                        if (note->m_realDuration > CHORD_CLUSTER_THRESHOLD)
+                            continue;
+                    }
+                }
+
+                // Cascade filter: tie-receiver whose sender was filtered
+                if ((note->m_grace1 & 0x0F) == 2) {
+                    const auto key = std::make_pair(v, note->m_semiTonePitch);
+                    auto it = std::find(filteredTieSenderPitches.begin(), filteredTieSenderPitches.end(), key);
+                    if (it != filteredTieSenderPitches.end()) {
+                        // erase all copies, as the set did
+                        filteredTieSenderPitches.erase(std::remove(it, filteredTieSenderPitches.end(), key), filteredTieSenderPitches.end());
+                        continue;
+                    }
+                }
+
+                voiceElems.push_back(elem);
+                voiceDurs.push_back(noteDur);
+                tick += isChord ? 0 : noteDur;
+            }
+            else if (const auto* rest = dynamic_cast<const EncMeasureElemRest*>(elem)) {
+                const int restDur = durationRest(rest);
+                if (restDur <= 0) continue;  // Skip invalid rests
+                if (tick + restDur > measureDur) continue;  // Skip rests that overflow
+                chordRootTick = (int)elem->m_tick;
+                voiceElems.push_back(elem);
+                voiceDurs.push_back(restDur);
+                tick += restDur;
+            }
+        }
+
+        // Find for each element the next NON-CHORD element (using the element's own
+        // tick as the chord root) and whether it is a tuplet (for closing current tuplet)
+        m_lookahead.init(voiceElems, voiceDurs);
+
+        // Second pass: accept elements and compute their written ticks.
+        // chordRootTick2 can differ from chordRootTick, as elements filtered in the
+        // first pass alter chordRootTick but are not seen here.
+        tick = 0;
+        int chordRootTick2 = -999;
+        int lastRootDur = 0;    // duration of last root note (for chord note <duration>)
+        for (size_t i = 0; i < voiceElems.size(); ++i) {
+            const auto elem = voiceElems[i];
+            const int dur = voiceDurs[i];
+            VoiceEvent ev;
+            if (const auto* note = dynamic_cast<const EncMeasureElemNote*>(elem)) {
+                // Same chord detection as first pass: compare to chord root, not previous note.
+                const bool isChord = isChordOf(chordRootTick2, note);
+
+                // Second-pass overflow guard: a note that was accepted by the first pass as a
+                // chord extension (isChord=true → no overflow check) may appear as a root here.
+                // Skip root notes whose written duration would push past the measure boundary,
+                // leaving chordRootTick2 unchanged.
+                if (!isChord) {
+                    if (tick + dur > measureDur)
+                        continue;
+                    chordRootTick2 = (int)note->m_tick;
+                }
+
+                ev.m_note = note;
+                ev.m_chord = isChord;
+                ev.m_duration = isChord ? 0 : dur;
+                // For chord notes, use the chord root's duration so that the MusicXML importer's
+                // measure-duration accumulation (mDura in pass 1) does not double-count chord notes
+                // that have different durations from their root (e.g. triplet 8th extension of a
+                // quarter root in a MIDI-recorded chord cluster).
+                ev.m_noteDuration = (isChord && lastRootDur > 0) ? lastRootDur : dur;
+                if (!isChord) lastRootDur = dur;
+            }
+            else if (const auto* rest = dynamic_cast<const EncMeasureElemRest*>(elem)) {
+                chordRootTick2 = (int)elem->m_tick;
+                ev.m_rest = rest;
+                ev.m_duration = dur;
+                ev.m_noteDuration = dur;
+            }
+            ev.m_tick = tick;
+            ev.m_nextNonChordIsTuplet = m_lookahead.nextNonChordIsTuplet(i);
+            ev.m_lastNonChord = m_lookahead.isLastNonChord(i);
+            m_events.push_back(ev);
+            tick += ev.m_duration;
+        }
+        ve.m_last = m_events.size();
+        ve.m_endTick = tick;
+        initNoteValues(ve);
+    }
+
+    // the events are complete, their address no longer changes
+    for (auto& ve : staffVoices)
+        ve.m_events = m_events.data();
+}
+
+
+//---------------------------------------------------------
+// initNoteValues - determine the note type, dots, tuplet ratio
+// and tuplet state of the events in a voice
+//---------------------------------------------------------
+
+void VoiceTimeline::initNoteValues(const VoiceEvents& ve)
+{
+    TupletHandler th;  // Each voice has its own tuplet handler
+    for (size_t i = ve.m_first; i < ve.m_last; ++i) {
+        auto& ev = m_events[i];
+        // Force close tuplet if this is the last tuplet note before a non-tuplet or end of measure
+        const bool forceClose = th.needsClose() && (!ev.m_nextNonChordIsTuplet || ev.m_lastNonChord);
+        const int duration = ev.m_noteDuration;
+        const quint8 faceValue = ev.m_note ? ev.m_note->m_faceValue : ev.m_rest->m_faceValue;
+        // Use correctFaceValue to fix type when duration doesn't match faceValue (common Encore bug)
+        ev.m_type = correctFaceValue(duration, faceValue);
+        // Always calculate dots from written duration (m_dotControl is unreliable in old format files)
+        ev.m_dots = calculateDots(duration, faceValue);
+        if (const auto note = ev.m_note) {
+            // Detect tuplet from duration if not set in file
+            ev.m_actualNotes = note->actualNotes();
+            ev.m_normalNotes = note->normalNotes();
+            if (ev.m_actualNotes == 0 && duration > 0) {
+                ev.m_actualNotes = detectTuplet(duration, note->m_faceValue, ev.m_normalNotes);
+            }
+        }
+        else if (const auto rest = ev.m_rest) {
+            // Use explicit tuplet info from Encore (don't auto-detect for rests)
+            ev.m_actualNotes = rest->actualNotes();
+            ev.m_normalNotes = rest->normalNotes();
+        }
+        // Don't count chord notes for tuplet state - they're simultaneous with the previous note
+        // Use calculated tick for proper grouping (m_tick from Encore can be inconsistent)
+        auto state = ev.m_chord ? TupletState::NONE : th.newNote(ev.m_actualNotes, ev.m_normalNotes, ev.m_tick, duration);
+        // Force close the tuplet, but NOT for chord notes - they shouldn't carry tuplet brackets
+        if (forceClose && !ev.m_chord && state == TupletState::NONE && th.needsClose()) {
+            state = TupletState::STOP;
+            th.close();
+        }
+        ev.m_tupletState = state;
+    }
+}
+
+
+//---------------------------------------------------------
+// voices - return the voices of staff staffIdx in measure measureNr
+// the result is valid until voices() is called for another staff or measure
+//---------------------------------------------------------
+
+const std::vector<VoiceEvents>& VoiceTimeline::voices(const size_t measureNr, const int staffIdx)
+{
+    static const std::vector<VoiceEvents> empty;
+    if (staffIdx < 0 || staffIdx > UCHAR_MAX || measureNr >= m_ef.measures().size())
+        return empty;
+    if (staffIdx != m_staffIdx || measureNr != m_measureNr) {
+        initStaff(m_ef.measures().at(measureNr), static_cast<quint8>(staffIdx), m_timeline.at(measureNr).m_durTicks);
+        m_measureNr = measureNr;
+        m_staffIdx = staffIdx;
+    }
+    return m_voices;
+}
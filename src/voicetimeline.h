@@ -0,0 +1,140 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+#ifndef VOICETIMELINE_H
+#define VOICETIMELINE_H
+
+#include <utility>
+#include <vector>
+
+#include "commondefs.h"
+#include "encfile.h"
+#include "noteconnector.h"
+#include "scoretimeline.h"
+
+
+//---------------------------------------------------------
+// the tuplet state handler deduces tuplet start and stop notes
+// Groups tuplets by counting notes until actualNotes is reached
+//---------------------------------------------------------
+
+class TupletHandler {
+public:
+    TupletHandler() {}
+    TupletState newNote(const quint8 actualNotes, const quint8 normalNotes, const int tick, const int duration);
+    bool needsClose() const { return m_inTuplet; }
+    void close() { m_inTuplet = false; m_groupStartTick = -1; m_groupDuration = 0; }
+private:
+    bool m_inTuplet { false };
+    int m_groupStartTick { -1 };
+    int m_groupDuration { 0 };
+};
+
+
+//---------------------------------------------------------
+// the voice lookahead finds for each element in a voice the next element
+// that is not a chord note of it, and whether that element is in a tuplet
+//---------------------------------------------------------
+
+class VoiceLookahead {
+public:
+    void init(const std::vector<const EncMeasureElem*>& elems, const std::vector<int>& durations);
+    bool isLastNonChord(const size_t i) const { return m_next.at(i) < 0; }
+    bool nextNonChordIsTuplet(const size_t i) const { return m_next.at(i) >= 0 && m_isTuplet.at(m_next.at(i)); }
+private:
+    std::vector<int> m_next;            // index of next non-chord element, -1 if none
+    std::vector<char> m_isTuplet;       // element is in a tuplet
+    std::vector<int> m_lowStack;        // candidates for the next tick below the chord window
+    std::vector<int> m_highStack;       // candidates for the next tick above the chord window
+    std::vector<int> m_keys;            // tick of each element, INT_MIN for rests
+};
+
+
+//---------------------------------------------------------
+// a single note or rest of a voice, after filtering MIDI artifacts
+// and quantising to written durations
+//---------------------------------------------------------
+
+struct VoiceEvent
+{
+    const EncMeasureElemNote* m_note    { nullptr };    // either note or rest is set
+    const EncMeasureElemRest* m_rest    { nullptr };
+    bool    m_chord                     { false };      // chord extension of the preceding root
+    int     m_tick                      { 0 };          // written start tick in the measure
+    int     m_duration                  { 0 };          // tick increment, 0 for chord extensions
+    int     m_noteDuration              { 0 };          // written duration, the chord root's for chord extensions
+    int     m_dots                      { 0 };
+    quint8  m_type                      { 0 };          // MusicXML note type, index in faceValueXmlTypes
+    bool    m_nextNonChordIsTuplet      { false };      // the next non-chord event is in a tuplet
+    bool    m_lastNonChord              { false };      // no non-chord event follows
+    int     m_actualNotes               { 0 };          // tuplet ratio, stored or inferred
+    int     m_normalNotes               { 0 };
+    TupletState m_tupletState           { TupletState::NONE };
+};
+
+
+//---------------------------------------------------------
+// the events of one voice in one staff of one measure
+// the events themselves are stored by the voice timeline
+//---------------------------------------------------------
+
+struct VoiceEvents
+{
+    quint8 m_voice { 0 };
+    size_t m_first { 0 };                               // index of the first event
+    size_t m_last { 0 };                                // index after the last event
+    const VoiceEvent* m_events { nullptr };             // all events of the staff
+    int m_endTick { 0 };                                // tick after the last event
+    const VoiceEvent* begin() const { return m_events + m_first; }
+    const VoiceEvent* end() const { return m_events + m_last; }
+};
+
+
+//---------------------------------------------------------
+// the voice timeline computes the normalised events of the
+// voices in one staff of one measure when they are requested,
+// only the most recently requested staff is kept
+// the storage is reused, so that after the largest staff has been
+// seen no memory is allocated anymore
+//---------------------------------------------------------
+
+class VoiceTimeline
+{
+public:
+    VoiceTimeline(const EncFile& ef, const NoteConnector& nc, const ScoreTimeline& timeline);
+    const std::vector<VoiceEvents>& voices(const size_t measureNr, const int staffIdx);
+private:
+    void initNoteValues(const VoiceEvents& ve);
+    void initStaff(const EncMeasure& m, const quint8 staffIdx, const int measureDur);
+    const EncFile& m_ef;
+    const NoteConnector& m_nc;
+    const ScoreTimeline& m_timeline;
+    std::vector<VoiceEvents> m_voices;  // the voices of staff m_staffIdx in measure m_measureNr
+    std::vector<VoiceEvent> m_events;   // their events, voice after voice
+    size_t m_measureNr { 0 };
+    int m_staffIdx { -1 };              // -1 if m_voices is not computed
+    // scratch buffers, reused to keep their capacity
+    std::vector<quint8> m_voiceNrs;
+    std::vector<const EncMeasureElem*> m_voiceElems;
+    std::vector<int> m_voiceDurs;
+    std::vector<std::pair<quint8, quint8>> m_filteredTieSenderPitches;  // voice, pitch
+    VoiceLookahead m_lookahead;
+};
+
+#endif // VOICETIMELINE_H
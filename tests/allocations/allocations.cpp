@@ -0,0 +1,145 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+//---------------------------------------------------------
+// check that the voice timeline does not allocate memory per measure:
+// once every staff of every measure of a file has been computed,
+// computing them all again must not allocate at all
+// only the voice stage is covered, not writing the MusicXML of a
+// measure (MxmlConverter::measureContents() and MxmlWriter)
+//---------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <QDir>
+#include <QStringList>
+
+#include "encfile.h"
+#include "encreader.h"
+#include "noteconnector.h"
+#include "scoretimeline.h"
+#include "voicetimeline.h"
+
+
+//---------------------------------------------------------
+// counting replacement of the global allocation functions
+//---------------------------------------------------------
+
+static std::atomic<long> allocations { 0 };
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+
+//---------------------------------------------------------
+// computeAll - compute the voices of all staves in all measures
+// returns the number of events found
+//---------------------------------------------------------
+
+static size_t computeAll(const EncFile& ef, VoiceTimeline& vt, const int staves)
+{
+    size_t events = 0;
+    for (size_t i = 0; i < ef.measures().size(); ++i) {
+        for (int s = 0; s < staves; ++s) {
+            for (const auto& ve : vt.voices(i, s))
+                events += ve.m_last - ve.m_first;
+        }
+    }
+    return events;
+}
+
+
+//---------------------------------------------------------
+// checkFile - check a single file, returns true on success
+//---------------------------------------------------------
+
+static bool checkFile(const QString& filename, const QString& name)
+{
+    EncFile ef;
+    const QString error = readEncFile(filename, ef);
+    if (!error.isEmpty()) {
+        std::printf("FAIL %s: %s\n", qPrintable(filename), qPrintable(error));
+        return false;
+    }
+
+    int staves = 0;
+    for (const auto& m : ef.measures()) {
+        for (const auto e : m.measureElems())
+            staves = std::max(staves, e->m_staffIdx + 1);
+    }
+
+    const NoteConnector nc(ef);
+    const ScoreTimeline timeline(ef);
+    VoiceTimeline vt(ef, nc, timeline);
+
+    const long before = allocations;
+    const size_t events = computeAll(ef, vt, staves);
+    const long warmup = allocations - before;
+
+    const long start = allocations;
+    const size_t eventsAgain = computeAll(ef, vt, staves);
+    const long again = allocations - start;
+
+    const bool ok = again == 0 && events == eventsAgain;
+    std::printf("%s %s: %zu measures, %zu events, %ld allocations first pass, %ld second pass\n",
+                ok ? "PASS" : "FAIL", qPrintable(name),
+                ef.measures().size(), events, warmup, again);
+    return ok;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const QDir dir(argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString(TESTDATA_DIR));
+    QStringList filters;
+    filters.append("*.enc");
+    const QStringList files = dir.entryList(filters, QDir::Files, QDir::Name);
+    if (files.isEmpty()) {
+        std::printf("FAIL no Encore files in %s\n", qPrintable(dir.path()));
+        return 1;
+    }
+
+    int failures = 0;
+    for (const auto& f : files) {
+        if (!checkFile(dir.filePath(f), f))
+            ++failures;
+    }
+
+    std::printf("%d file(s), %d failure(s)\n", static_cast<int>(files.size()), failures);
+    return failures ? 1 : 0;
+}
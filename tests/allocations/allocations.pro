@@ -0,0 +1,16 @@
+QT       = core
+
+CONFIG  += c++11
+
+TARGET   = tst_allocations
+TEMPLATE = app
+CONFIG  += console testcase
+CONFIG  -= app_bundle
+
+# debug output would allocate while counting
+DEFINES += QT_NO_DEBUG_OUTPUT
+DEFINES += TESTDATA_DIR=\\\"$$PWD/../../testdata\\\"
+
+include(../../src/core.pri)
+
+SOURCES += allocations.cpp
@@ -0,0 +1,184 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+//---------------------------------------------------------
+// check the C interface of the conversion library through its
+// exported functions only: conversion to a buffer and to a sink
+// gives the reference MusicXML, and each error is reported
+//---------------------------------------------------------
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "enc2musicxml.h"
+
+
+static int checks = 0;
+static int failures = 0;
+
+static void check(const bool ok, const char* what)
+{
+    ++checks;
+    if (!ok) {
+        ++failures;
+        std::printf("FAIL %s\n", what);
+    }
+}
+
+
+//---------------------------------------------------------
+// readFile - the contents of a file in the test data directory
+//---------------------------------------------------------
+
+static std::string readFile(const char* name)
+{
+    std::ifstream file(std::string(TESTDATA_DIR) + "/" + name, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+
+//---------------------------------------------------------
+// the callbacks
+//---------------------------------------------------------
+
+// append to the std::string in context
+static int appendSink(void* context, const char* data, size_t size)
+{
+    static_cast<std::string*>(context)->append(data, size);
+    return 0;
+}
+
+// fail on the first call
+static int failingSink(void*, const char*, size_t)
+{
+    return 1;
+}
+
+// count the calls in the int in context, cancel after the tenth
+static int cancellingProgress(void* context, const e2m_progress_info*)
+{
+    int& calls = *static_cast<int*>(context);
+    return ++calls >= 10 ? 1 : 0;
+}
+
+// check the progress information, count the calls in the int in context
+static int countingProgress(void* context, const e2m_progress_info* info)
+{
+    check(info && info->part >= 1 && info->part <= info->partCount
+          && info->measure >= 1 && info->measure <= info->measureCount
+          && info->measuresDone <= info->measuresTotal, "progress info");
+    ++*static_cast<int*>(context);
+    return 0;
+}
+
+
+//---------------------------------------------------------
+// checkConversion - buffer and sink give the reference output
+//---------------------------------------------------------
+
+static void checkConversion()
+{
+    const std::string enc = readFile("bazo.enc");
+    const std::string ref = readFile("bazo.ref.xml");
+    check(!enc.empty() && !ref.empty(), "test data");
+
+    char* output = nullptr;
+    size_t outputSize = 0;
+    check(e2m_convert_to_buffer(enc.data(), enc.size(), &output, &outputSize) == E2M_OK, "buffer status");
+    check(output && std::string(output, outputSize) == ref, "buffer output");
+    check(output && output[outputSize] == '\0', "buffer null-terminated");
+    e2m_free(output);
+
+    std::string sunk;
+    check(e2m_convert_to_sink(enc.data(), enc.size(), appendSink, &sunk) == E2M_OK, "sink status");
+    check(sunk == ref, "sink output");
+
+    int calls = 0;
+    sunk.clear();
+    check(e2m_convert_to_sink_with_progress(enc.data(), enc.size(), appendSink, &sunk, countingProgress, &calls) == E2M_OK,
+          "sink with progress status");
+    check(sunk == ref && calls > 0, "sink with progress output");
+}
+
+
+//---------------------------------------------------------
+// checkErrors - invalid arguments, unreadable input, sink errors
+// and cancellation
+//---------------------------------------------------------
+
+static void checkErrors()
+{
+    const std::string enc = readFile("atraing.enc");
+    char* output = nullptr;
+    size_t outputSize = 0;
+    std::string sunk;
+
+    check(e2m_convert_to_buffer(nullptr, enc.size(), &output, &outputSize) == E2M_ERROR_INVALID_ARGUMENT, "buffer null data");
+    check(e2m_convert_to_buffer(enc.data(), 0, &output, &outputSize) == E2M_ERROR_INVALID_ARGUMENT, "buffer empty data");
+    check(e2m_convert_to_buffer(enc.data(), enc.size(), nullptr, &outputSize) == E2M_ERROR_INVALID_ARGUMENT, "buffer null output");
+    check(e2m_convert_to_buffer(enc.data(), enc.size(), &output, nullptr) == E2M_ERROR_INVALID_ARGUMENT, "buffer null size");
+    check(e2m_convert_to_sink(nullptr, enc.size(), appendSink, &sunk) == E2M_ERROR_INVALID_ARGUMENT, "sink null data");
+    check(e2m_convert_to_sink(enc.data(), enc.size(), nullptr, &sunk) == E2M_ERROR_INVALID_ARGUMENT, "sink null sink");
+
+    const std::string zbot = std::string("ZBOT") + std::string(60, '\0');
+    check(e2m_convert_to_buffer(zbot.data(), zbot.size(), &output, &outputSize) == E2M_ERROR_ZBOT_FORMAT, "buffer ZBOT");
+    check(!output && outputSize == 0, "buffer ZBOT output");
+    check(e2m_convert_to_sink(zbot.data(), zbot.size(), appendSink, &sunk) == E2M_ERROR_ZBOT_FORMAT, "sink ZBOT");
+    check(sunk.empty(), "sink ZBOT output");
+
+    const std::string text = "this is not an Encore file";
+    check(e2m_convert_to_buffer(text.data(), text.size(), &output, &outputSize) == E2M_ERROR_READ, "buffer unreadable");
+    check(e2m_convert_to_sink(text.data(), text.size(), appendSink, &sunk) == E2M_ERROR_READ, "sink unreadable");
+
+    check(e2m_convert_to_sink(enc.data(), enc.size(), failingSink, nullptr) == E2M_ERROR_WRITE, "sink error");
+
+    int calls = 0;
+    check(e2m_convert_to_buffer_with_progress(enc.data(), enc.size(), &output, &outputSize, cancellingProgress, &calls)
+          == E2M_ERROR_CANCELLED, "buffer cancelled");
+    check(!output && outputSize == 0 && calls == 10, "buffer cancelled output");
+    calls = 0;
+    check(e2m_convert_to_sink_with_progress(enc.data(), enc.size(), appendSink, &sunk, cancellingProgress, &calls)
+          == E2M_ERROR_CANCELLED, "sink cancelled");
+    check(calls == 10, "sink cancelled calls");
+}
+
+
+//---------------------------------------------------------
+// checkStrings - every status has a description
+//---------------------------------------------------------
+
+static void checkStrings()
+{
+    for (int status = E2M_OK; status <= E2M_ERROR_CANCELLED; ++status)
+        check(std::strcmp(e2m_status_string(static_cast<e2m_status>(status)), "unknown error") != 0, "status string");
+    check(std::strcmp(e2m_version(), "0.7") == 0, "version");
+}
+
+
+int main()
+{
+    checkConversion();
+    checkErrors();
+    checkStrings();
+    std::printf("%d check(s), %d failure(s)\n", checks, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+QT       = core
+
+CONFIG  += c++11
+
+TARGET   = tst_capi
+TEMPLATE = app
+CONFIG  += console testcase
+CONFIG  -= app_bundle
+
+DEFINES += TESTDATA_DIR=\\\"$$PWD/../../testdata\\\"
+
+# only the library's exported C interface is used
+INCLUDEPATH += $$PWD/../../src/lib
+LIBS += -L$$OUT_PWD/../../src/lib -lenc2musicxml
+QMAKE_RPATHDIR += $$OUT_PWD/../../src/lib
+
+SOURCES += capi.cpp
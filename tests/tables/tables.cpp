@@ -0,0 +1,299 @@
+/*****************************************************************************/
+/*  Enc2MusicXML - Converts musical notation from Encore to MusicXML.        */
+/*  Copyright (C) 2018 Leon Vinken                                           */
+/*                                                                           */
+/*  This program is free software; you can redistribute it and/or modify     */
+/*  it under the terms of the GNU General Public License as published by     */
+/*  the Free Software Foundation; either version 3, or (at your option)      */
+/*  any later version.                                                       */
+/*                                                                           */
+/*  This program is distributed in the hope that it will be useful,          */
+/*  but WITHOUT ANY WARRANTY; without even the implied warranty of           */
+/*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            */
+/*  GNU General Public License for more details.                             */
+/*                                                                           */
+/*  You should have received a copy of the GNU General Public License        */
+/*  along with this program; if not, write to the Free Software Foundation,  */
+/*  Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.           */
+/*****************************************************************************/
+
+//---------------------------------------------------------
+// check the compile-time note value and pitch spelling tables, and the
+// functions of the MusicXML, analysis and text writers using them,
+// against the switch statements and computations they replaced
+//---------------------------------------------------------
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <QString>
+
+#include "notevalues.h"
+#include "scoretimeline.h"
+
+
+static int checks = 0;
+static int failures = 0;
+
+static void check(const bool ok, const char* what, const int value)
+{
+    ++checks;
+    if (!ok) {
+        ++failures;
+        std::printf("FAIL %s for %d\n", what, value);
+    }
+}
+
+
+//---------------------------------------------------------
+// the original implementations
+//---------------------------------------------------------
+
+static int oldFaceValue2duration(const quint8 faceValue)
+{
+    switch (faceValue) {
+    case 1: return  960;
+    case 2: return  480;
+    case 3: return  240;
+    case 4: return  120;
+    case 5: return   60;
+    case 6: return   30;
+    case 7: return   15;
+    case 8: return    7;
+    }
+    return 0;
+}
+
+static const char* oldFaceValue2Lily(const quint8 faceValue)
+{
+    switch (faceValue) {
+    case 0: return "0";
+    case 1: return "1";
+    case 2: return "2";
+    case 3: return "4";
+    case 4: return "8";
+    case 5: return "16";
+    case 6: return "32";
+    case 7: return "64";
+    case 8: return "128";
+    }
+    return "???";
+}
+
+static const char* oldFaceValue2xml(const quint8 faceValue)
+{
+    switch (faceValue) {
+    case 1: return "whole";
+    case 2: return "half";
+    case 3: return "quarter";
+    case 4: return "eighth";
+    case 5: return "16th";
+    case 6: return "32nd";
+    case 7: return "64th";
+    case 8: return "128th";
+    }
+    return "???";
+}
+
+static const char* oldCorrectNoteType(const int realDuration, const quint8 faceValue)
+{
+    const char* originalType = oldFaceValue2xml(faceValue & 0x0F);
+
+    if (realDuration <= 0) {
+        return originalType;
+    }
+
+    const char* correctType = originalType;
+
+    if (realDuration == 960) correctType = "whole";
+    else if (realDuration == 480) correctType = "half";
+    else if (realDuration == 240) correctType = "quarter";
+    else if (realDuration == 120) correctType = "eighth";
+    else if (realDuration == 60) correctType = "16th";
+    else if (realDuration == 30) correctType = "32nd";
+    else if (realDuration == 15) correctType = "64th";
+    else if (realDuration == 720) correctType = "half";
+    else if (realDuration == 360) correctType = "quarter";
+    else if (realDuration == 180) correctType = "eighth";
+    else if (realDuration == 90) correctType = "16th";
+    else if (realDuration == 45) correctType = "32nd";
+    else if (realDuration == 640) correctType = "whole";
+    else if (realDuration == 320) correctType = "half";
+    else if (realDuration == 160) correctType = "quarter";
+    else if (realDuration == 80) correctType = "eighth";
+    else if (realDuration == 40) correctType = "16th";
+    else if (realDuration == 20) correctType = "32nd";
+    else if (realDuration == 10) correctType = "64th";
+
+    return correctType;
+}
+
+static int alterTab[12] = { 0,   1,   0,   1,   0,  0,   1,   0,   1,   0,   1,   0 };
+static char noteTab[12] = { 'C', 'C', 'D', 'D', 'E', 'F', 'F', 'G', 'G', 'A', 'A', 'B' };
+
+static void oldMidipitch2xml(const quint8 pitch, const accidentalType accid, const int fifths,
+                             char& step, int& alter, int& octave)
+{
+    if (accid == accidentalType::FLAT) {
+        step   = noteTab[(pitch + 1) % 12];
+        alter  = -1;
+        octave = (pitch + 1) / 12 - 1;
+    }
+    else if (alterTab[pitch % 12] && accid == accidentalType::NONE && fifths < 0) {
+        step   = noteTab[(pitch + 1) % 12];
+        alter  = -1;
+        octave = (pitch + 1) / 12 - 1;
+    }
+    else {
+        step   = noteTab[pitch % 12];
+        alter  = alterTab[pitch % 12];
+        octave = pitch / 12 - 1;
+    }
+}
+
+// analysisfile.cpp
+
+static void oldAnalysisMidipitch2xml(const quint8 pitch, char& step, int& alter, int& octave)
+{
+    step   = noteTab[pitch % 12];
+    alter  = alterTab[pitch % 12];
+    octave = pitch / 12 - 1;
+}
+
+static const char* oldFaceValue2string(const quint8 faceValue)
+{
+    switch (faceValue) {
+    case 1: return "/1";
+    case 2: return "/2";
+    case 3: return "/4";
+    case 4: return "/8";
+    case 5: return "/16";
+    case 6: return "/32";
+    case 7: return "/64";
+    case 8: return "/128";
+    }
+
+    return "???";
+}
+
+// textfile.cpp
+
+static QString oldSemiTonePitch2Lily(const quint8 semiTonePitch)
+{
+    QString res;
+    const int note = semiTonePitch % 12;
+    const int oct  = semiTonePitch / 12;
+
+    switch (note)
+    {
+    case  0: res = "c"; break;
+    case  1: res = "des"; break;
+    case  2: res = "d"; break;
+    case  3: res = "es"; break;
+    case  4: res = "e"; break;
+    case  5: res = "f"; break;
+    case  6: res = "ges"; break;
+    case  7: res = "g"; break;
+    case  8: res = "aes"; break;
+    case  9: res = "a"; break;
+    case 10: res = "bes"; break;
+    case 11: res = "b"; break;
+    }
+
+    for (int i = oct; i > 4; i--)
+        res += "'";
+
+    for (int i = oct; i < 4; ++i)
+        res += ",";
+
+    return res;
+}
+
+static int oldEncKeyToFifths(unsigned int key)
+{
+    const std::vector<int> v =
+        {
+            //   c   f  bf  ef  af  df  gf  cf  g   d   a   e   b  fs  cs
+            /**/ 0, -1, -2, -3, -4, -5, -6, -7, 1,  2,  3,  4,  5,  6,  7
+        };
+    if (key >= v.size()) {
+        return 0;
+    }
+    return v.at(key);
+}
+
+
+//---------------------------------------------------------
+// the checks
+//---------------------------------------------------------
+
+static void checkFaceValues()
+{
+    for (int fv = 0; fv < 256; ++fv) {
+        check(faceValue2duration(fv) == oldFaceValue2duration(fv), "faceValue2duration", fv);
+        check(std::strcmp(faceValue2denominator(fv), oldFaceValue2Lily(fv)) == 0, "faceValue2denominator", fv);
+        check(faceValue2xml(fv) == QString::fromLatin1(oldFaceValue2xml(fv)), "faceValue2xml", fv);
+        check(faceValue2string(fv) == oldFaceValue2string(fv), "faceValue2string", fv);
+    }
+}
+
+static void checkNoteTypes()
+{
+    for (int fv = 0; fv < 256; ++fv) {
+        for (int duration = -1; duration <= 1000; ++duration) {
+            const quint8 type = correctFaceValue(duration, fv);
+            check(type < FACEVALUE_COUNT
+                  && std::strcmp(faceValueXmlTypes[type], oldCorrectNoteType(duration, fv)) == 0,
+                  "correctFaceValue", fv * 10000 + duration);
+        }
+    }
+}
+
+static void checkPitchSpelling()
+{
+    const accidentalType accids[] = { accidentalType::NONE, accidentalType::SHARP, accidentalType::FLAT, accidentalType::NATURAL };
+    for (int pitch = 0; pitch < 256; ++pitch) {
+        check(isAlteredPitch(pitch) == (alterTab[pitch % 12] != 0), "isAlteredPitch", pitch);
+        for (const auto accid : accids) {
+            for (int fifths = -7; fifths <= 7; ++fifths) {
+                char step = ' ';
+                int alter = 0;
+                int octave = 0;
+                oldMidipitch2xml(pitch, accid, fifths, step, alter, octave);
+                char newStep = ' ';
+                int newAlter = 0;
+                int newOctave = 0;
+                midipitch2xml(pitch, accid, fifths, newStep, newAlter, newOctave);
+                check(newStep == step && newAlter == alter && newOctave == octave, "midipitch2xml", pitch);
+            }
+        }
+        char step = ' ';
+        int alter = 0;
+        int octave = 0;
+        oldAnalysisMidipitch2xml(pitch, step, alter, octave);
+        char newStep = ' ';
+        int newAlter = 0;
+        int newOctave = 0;
+        midipitch2xml(pitch, newStep, newAlter, newOctave);
+        check(newStep == step && newAlter == alter && newOctave == octave, "midipitch2xml (analysis)", pitch);
+        check(semiTonePitch2Lily(pitch) == oldSemiTonePitch2Lily(pitch), "semiTonePitch2Lily", pitch);
+    }
+}
+
+static void checkKeys()
+{
+    for (unsigned int key = 0; key < 32; ++key)
+        check(encKeyToFifths(key) == oldEncKeyToFifths(key), "encKeyToFifths", key);
+}
+
+
+int main()
+{
+    checkFaceValues();
+    checkNoteTypes();
+    checkPitchSpelling();
+    checkKeys();
+    std::printf("%d check(s), %d failure(s)\n", checks, failures);
+    return failures ? 1 : 0;
+}
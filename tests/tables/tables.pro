@@ -0,0 +1,12 @@
+QT       = core
+
+CONFIG  += c++11
+
+TARGET   = tst_tables
+TEMPLATE = app
+CONFIG  += console testcase
+CONFIG  -= app_bundle
+
+include(../../src/core.pri)
+
+SOURCES += tables.cpp
@@ -0,0 +1,6 @@
+# unit tests, run them with: make check
+
+TEMPLATE = subdirs
+SUBDIRS += allocations \
+           capi \
+           tables